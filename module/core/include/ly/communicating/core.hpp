@@ -1,9 +1,21 @@
 #pragma once
 
+#include "core/async_task.hpp"
 #include "core/basic_bytes.hpp"
 #include "core/basic_tasks.hpp"
+#include "core/batch_writer_task.hpp"
 #include "core/byte_reader.hpp"
 #include "core/byte_rwer.hpp"
 #include "core/byte_writer.hpp"
+#include "core/cobs.hpp"
+#include "core/crc.hpp"
+#include "core/delta_codec.hpp"
+#include "core/idle_policy.hpp"
+#include "core/length_frame_decoder.hpp"
+#include "core/loopback.hpp"
+#include "core/message_router.hpp"
+#include "core/message_schema.hpp"
 #include "core/ping_pong_buffer.hpp"
+#include "core/ring_decoder.hpp"
+#include "core/task_metrics.hpp"
 #include "core/typed_message.hpp"
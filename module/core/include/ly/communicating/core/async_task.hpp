@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "basic_bytes.hpp"
+
+namespace ly::communicating {
+    namespace details {
+        /// @brief 协程帧的线程内对象池
+        /// @details
+        ///		按 64 字节分级，每级一条空闲链表，释放的帧挂回链表供下一次复用，不归还给系统。
+        ///		长期运行的会话只在首次创建各级帧时分配内存，之后每帧数据、每次调用子协程都不再访问堆。
+        ///		超过 max_pooled_size 的帧直接使用 ::operator new 。
+        class frame_pool {
+            static constexpr size_type granularity = 64;
+            static constexpr size_type max_pooled_size = 4096;
+            static constexpr size_type class_count = max_pooled_size / granularity;
+
+            struct free_block {
+                free_block *next;
+            };
+
+            std::array<free_block *, class_count> free_lists{};
+
+            [[nodiscard]] static constexpr size_type class_of(const size_type size) noexcept {
+                return (size + granularity - 1) / granularity - 1;
+            }
+
+        public:
+            frame_pool() = default;
+            frame_pool(const frame_pool &) = delete;
+            frame_pool &operator=(const frame_pool &) = delete;
+
+            ~frame_pool() {
+                for (auto head : free_lists) {
+                    while (head != nullptr) {
+                        const auto next = head->next;
+                        ::operator delete(head);
+                        head = next;
+                    }
+                }
+            }
+
+            [[nodiscard]] void *allocate(const size_type size) {
+                if (size > max_pooled_size) return ::operator new(size);
+                auto &head = free_lists[class_of(size)];
+                if (head == nullptr) return ::operator new((class_of(size) + 1) * granularity);
+                return std::exchange(head, head->next);
+            }
+
+            void deallocate(void *pointer, const size_type size) noexcept {
+                if (size > max_pooled_size) {
+                    ::operator delete(pointer);
+                    return;
+                }
+                auto &head = free_lists[class_of(size)];
+                head = ::new(pointer) free_block{head};
+            }
+
+            /// @brief 当前线程的对象池，帧在哪个线程释放就回到哪个线程的池中
+            [[nodiscard]] static frame_pool &local() noexcept {
+                thread_local frame_pool pool;
+                return pool;
+            }
+        };
+
+        /// @brief 协程承诺的公共部分：帧从 @c frame_pool 分配，结束时对称转移到等待者
+        class async_promise_base {
+            std::coroutine_handle<> continuation;
+            /// @brief 分离运行时由执行器提供，结束时递减并销毁自身的帧
+            size_type *detached_count{nullptr};
+
+        protected:
+            std::exception_ptr exception;
+
+        public:
+            static void *operator new(const size_type size) { return frame_pool::local().allocate(size); }
+
+            static void operator delete(void *pointer, const size_type size) noexcept {
+                frame_pool::local().deallocate(pointer, size);
+            }
+
+            struct final_awaiter {
+                [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+                template<typename promise_type>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                    async_promise_base &promise = handle.promise();
+                    if (promise.continuation) return promise.continuation;
+                    if (promise.detached_count != nullptr) {
+                        if (promise.exception) std::terminate();
+                        --*promise.detached_count;
+                        handle.destroy();
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            [[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+            [[nodiscard]] final_awaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+            void set_continuation(const std::coroutine_handle<> handle) noexcept { continuation = handle; }
+            void set_detached(size_type *count) noexcept { detached_count = count; }
+        };
+
+        template<typename value_type>
+        class async_promise : public async_promise_base {
+            std::optional<value_type> value;
+
+        public:
+            template<typename result_type>
+            void return_value(result_type &&result) { value.emplace(std::forward<result_type>(result)); }
+
+            value_type take() {
+                if (exception) std::rethrow_exception(exception);
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        class async_promise<void> : public async_promise_base {
+        public:
+            void return_void() const noexcept {}
+
+            void take() const {
+                if (exception) std::rethrow_exception(exception);
+            }
+        };
+    }
+
+    /// @brief 惰性启动的协程任务，被 co_await 时才开始运行，结束后对称转移回等待者
+    /// @details
+    ///		帧从线程内的 @c details::frame_pool 分配，可以在协程中以 co_await 调用子任务组织多步协议，
+    ///		例如 发送请求 → 等待应答 → 超时重发，而不必手写状态机。
+    ///		顶层任务交给执行器（例如 @c posix::coroutine_executor::spawn）分离运行，结束时自行销毁；
+    ///		分离运行的任务抛出异常时调用 std::terminate ，与 std::thread 相同。
+    /// @tparam value_type 返回值类型
+    template<typename value_type = void>
+    class [[nodiscard]] async_task {
+    public:
+        struct promise_type : details::async_promise<value_type> {
+            async_task get_return_object() noexcept {
+                return async_task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+        };
+
+        using handle_type = std::coroutine_handle<promise_type>;
+
+    private:
+        handle_type handle;
+
+        explicit async_task(const handle_type handle) noexcept : handle(handle) {}
+
+    public:
+        async_task(async_task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        async_task &operator=(async_task &&other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        ~async_task() {
+            if (handle) handle.destroy();
+        }
+
+        /// @brief 交出协程句柄的所有权，由执行器负责运行与销毁
+        [[nodiscard]] handle_type release() noexcept { return std::exchange(handle, {}); }
+
+        struct awaiter {
+            handle_type handle;
+
+            [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(const std::coroutine_handle<> waiting) const noexcept {
+                handle.promise().set_continuation(waiting);
+                return handle;
+            }
+
+            value_type await_resume() const { return handle.promise().take(); }
+        };
+
+        awaiter operator co_await() const & noexcept { return awaiter{handle}; }
+    };
+}
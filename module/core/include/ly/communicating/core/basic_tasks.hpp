@@ -1,11 +1,15 @@
 #pragma once
 
 #include <concepts>
+#include <functional>
 #include <memory>
 #include <atomic>
 #include <optional>
+#include <type_traits>
 
 #include "basic_bytes.hpp"
+#include "idle_policy.hpp"
+#include "task_metrics.hpp"
 
 namespace ly::communicating {
     template<typename object_type>
@@ -38,6 +42,28 @@ namespace ly::communicating {
         { object.get(item) } -> std::same_as<bool>;
     };
 
+    /// @brief 原地包装器，提供内部缓冲区供读取器直接写入，解析后直接提供内部的包裹，省去两次拷贝
+    template<typename object_type, typename item_type = typename object_type::item_type>
+    concept is_inplace_packer = requires(object_type &object) {
+        { object.as_buffer() } -> std::same_as<byte_span>;
+        { object.pack() } -> std::same_as<bool>;
+        { object.as_item() } -> std::convertible_to<const item_type &>;
+    };
+
+    /// @brief 原地拆包器，提供内部包裹供来源直接写入，拆包后直接提供内部的缓冲区，省去两次拷贝
+    template<typename object_type, typename item_type = typename object_type::item_type>
+    concept is_inplace_unpacker = requires(object_type &object) {
+        { object.as_item() } -> std::same_as<item_type &>;
+        { object.unpack() } -> std::same_as<bool>;
+        { object.as_buffer() } -> std::same_as<byte_span>;
+    };
+
+    template<typename object_type>
+    concept is_task_packer = is_byte_packer<object_type> || is_inplace_packer<object_type>;
+
+    template<typename object_type>
+    concept is_task_unpacker = is_item_unpacker<object_type> || is_inplace_unpacker<object_type>;
+
     template<typename object_type>
     concept is_result_monitor = requires(object_type &object, int result) {
         { object.handle(result) } -> std::same_as<bool>;
@@ -52,106 +78,342 @@ namespace ly::communicating {
         source_failure = -6
     };
 
+    namespace details {
+        /// @brief 标准流程中任务自身持有的缓冲区与包裹，原地流程中为空
+        template<typename item_type, bool enabled>
+        struct task_storage {
+            byte_array<sizeof(item_type)> buffer{};
+            item_type item{};
+        };
+
+        template<typename item_type>
+        struct task_storage<item_type, false> {};
+
+        /// @brief 流水线阶段的持有方式：按值持有对象本身，std::reference_wrapper 引用外部对象，std::shared_ptr 共享持有
+        template<typename stage_type>
+        struct stage_traits {
+            using object_type = stage_type;
+
+            static object_type &get(stage_type &stage) noexcept { return stage; }
+        };
+
+        template<typename object_type_>
+        struct stage_traits<std::reference_wrapper<object_type_>> {
+            using object_type = object_type_;
+
+            static object_type &get(const std::reference_wrapper<object_type> &stage) noexcept { return stage.get(); }
+        };
+
+        template<typename object_type_>
+        struct stage_traits<std::shared_ptr<object_type_>> {
+            using object_type = object_type_;
+
+            static object_type &get(const std::shared_ptr<object_type> &stage) noexcept { return *stage; }
+        };
+
+        template<typename stage_type>
+        using stage_object_t = typename stage_traits<stage_type>::object_type;
+
+        template<typename stage_type>
+        stage_object_t<stage_type> &get_stage(stage_type &stage) noexcept { return stage_traits<stage_type>::get(stage); }
+    }
+
+    /// @brief 将返回字节数的读取器（例如 @c byte_reader 的派生类）适配为 @c is_byte_reader ，读满缓冲区时成功
+    /// @details 按具体的 final 类型持有时，虚函数调用在编译期去虚化
+    /// @tparam reader_stage 读取器，或其 std::reference_wrapper 、std::shared_ptr
+    template<typename reader_stage>
+    class exact_reader {
+        [[no_unique_address]] reader_stage reader;
+
+    public:
+        explicit exact_reader(reader_stage reader) : reader(std::move(reader)) {}
+
+        bool read(const byte_span buffer) { return details::get_stage(reader).read(buffer) == buffer.size(); }
+    };
+
+    template<typename reader_stage>
+    exact_reader(reader_stage) -> exact_reader<reader_stage>;
+
+    /// @brief 将返回字节数的写入器（例如 @c byte_writer 的派生类）适配为 @c is_byte_writer ，写完缓冲区时成功
+    template<typename writer_stage>
+    class exact_writer {
+        [[no_unique_address]] writer_stage writer;
+
+    public:
+        explicit exact_writer(writer_stage writer) : writer(std::move(writer)) {}
+
+        bool write(const byte_span buffer) { return details::get_stage(writer).write(buffer) == buffer.size(); }
+    };
+
+    template<typename writer_stage>
+    exact_writer(writer_stage) -> exact_writer<writer_stage>;
+
+    /// @brief 读取流水线：read → pack → set ，各阶段的静态类型在编译期确定
+    /// @details
+    ///		阶段按值持有时对象嵌入流水线内部，没有指针跳转，final 类的虚函数也会被去虚化，编译器可以把整条链内联成一个函数。
+    ///		阶段也可以是 std::reference_wrapper 或 std::shared_ptr ，@c reader_task 就是全部阶段为 std::shared_ptr 的流水线。
+    /// @tparam reader_stage 读取器，或其 std::reference_wrapper 、std::shared_ptr
+    /// @tparam metrics_type 任务度量，默认 @c no_metrics 在编译期消除，使用 @c task_metrics 时记录 read、pack、set 三个阶段的耗时
     template<
-        typename reader_type,
-        typename packer_type,
-        typename sink_type>
+        typename reader_stage,
+        typename packer_stage,
+        typename sink_stage,
+        typename metrics_type = no_metrics,
+        typename reader_type = details::stage_object_t<reader_stage>,
+        typename packer_type = details::stage_object_t<packer_stage>,
+        typename sink_type = details::stage_object_t<sink_stage>>
         requires (std::is_same_v<typename packer_type::item_type, typename sink_type::item_type>)
                  && is_byte_reader<reader_type>
-                 && is_byte_packer<packer_type>
+                 && is_task_packer<packer_type>
                  && is_item_sink<sink_type>
-    class reader_task {
-        using item_type = typename reader_type::item_type;
-        std::shared_ptr<reader_type> reader;
-        std::shared_ptr<packer_type> packer;
-        std::shared_ptr<sink_type> sink;
-        byte_array<sizeof(item_type)> buffer;
-        item_type item;
+                 && is_task_metrics<metrics_type>
+    class reader_pipeline {
+        using item_type = typename packer_type::item_type;
+        static constexpr bool is_inplace = is_inplace_packer<packer_type>;
+
+        [[no_unique_address]] reader_stage reader;
+        [[no_unique_address]] packer_stage packer;
+        [[no_unique_address]] sink_stage sink;
+        [[no_unique_address]] details::task_storage<item_type, !is_inplace> storage;
+        [[no_unique_address]] metrics_type metrics;
 
     public:
-        reader_task(std::shared_ptr<reader_type> reader,
-            std::shared_ptr<packer_type> packer,
-            std::shared_ptr<sink_type> sink) :
-            reader(reader), packer(packer), sink(sink) {}
+        reader_pipeline(reader_stage reader, packer_stage packer, sink_stage sink) :
+            reader(std::move(reader)), packer(std::move(packer)), sink(std::move(sink)) {}
 
+        /// @note 包装器满足 @c is_inplace_packer 时，编译期选择原地流程，读取与投递都直接使用包装器内部的内存
         int run_once() noexcept {
-            if (!reader->read(buffer)) return reader_failure;
-            if (!packer->pack(buffer, item)) return packer_failure;
-            if (!sink->set(item)) return sink_failure;
+            auto &reader = get_reader();
+            auto &packer = get_packer();
+            auto &sink = get_sink();
+            auto stamp = metrics.start();
+            if constexpr (is_inplace) {
+                const auto buffer = packer.as_buffer();
+                if (!reader.read(buffer)) return metrics.fail(reader_failure);
+                metrics.lap(stamp, 0);
+                if (!packer.pack()) return metrics.fail(packer_failure);
+                metrics.lap(stamp, 1);
+                if (!sink.set(packer.as_item())) return metrics.fail(sink_failure);
+                metrics.lap(stamp, 2);
+                metrics.done(buffer.size());
+            } else {
+                if (!reader.read(storage.buffer)) return metrics.fail(reader_failure);
+                metrics.lap(stamp, 0);
+                if (!packer.pack(storage.buffer, storage.item)) return metrics.fail(packer_failure);
+                metrics.lap(stamp, 1);
+                if (!sink.set(storage.item)) return metrics.fail(sink_failure);
+                metrics.lap(stamp, 2);
+                metrics.done(storage.buffer.size());
+            }
             return 0;
         }
 
         int operator()() noexcept { return run_once(); }
+
+        [[nodiscard]] reader_type &get_reader() noexcept { return details::get_stage(reader); }
+        [[nodiscard]] packer_type &get_packer() noexcept { return details::get_stage(packer); }
+        [[nodiscard]] sink_type &get_sink() noexcept { return details::get_stage(sink); }
+
+        /// @brief 任务度量，可以在其他线程中调用其 snapshot
+        [[nodiscard]] const metrics_type &get_metrics() const noexcept { return metrics; }
     };
 
+    /// @brief 组合读取流水线，参数按值保存，需要引用外部对象时传入 std::ref ，需要共享时传入 std::shared_ptr
+    /// @code
+    /// auto task = pipeline(frame_reader{fd}, imu_schema::packer{}, std::ref(queue));
+    /// while (running) task();
+    /// @endcode
+    template<typename metrics_type = no_metrics, typename reader_stage, typename packer_stage, typename sink_stage>
+    [[nodiscard]] auto pipeline(reader_stage &&reader, packer_stage &&packer, sink_stage &&sink) {
+        return reader_pipeline<std::decay_t<reader_stage>, std::decay_t<packer_stage>, std::decay_t<sink_stage>, metrics_type>{
+            std::forward<reader_stage>(reader), std::forward<packer_stage>(packer), std::forward<sink_stage>(sink)
+        };
+    }
+
+    /// @brief 以 std::shared_ptr 持有各阶段的读取任务，是 @c reader_pipeline 的适配形式
+    /// @tparam metrics_type 任务度量，默认 @c no_metrics 在编译期消除，使用 @c task_metrics 时记录 read、pack、set 三个阶段的耗时
+    template<
+        typename reader_type,
+        typename packer_type,
+        typename sink_type,
+        typename metrics_type = no_metrics>
+        requires (std::is_same_v<typename packer_type::item_type, typename sink_type::item_type>)
+                 && is_byte_reader<reader_type>
+                 && is_task_packer<packer_type>
+                 && is_item_sink<sink_type>
+                 && is_task_metrics<metrics_type>
+    class reader_task : public reader_pipeline<
+            std::shared_ptr<reader_type>, std::shared_ptr<packer_type>, std::shared_ptr<sink_type>, metrics_type> {
+        using base = reader_pipeline<
+            std::shared_ptr<reader_type>, std::shared_ptr<packer_type>, std::shared_ptr<sink_type>, metrics_type>;
+
+    public:
+        reader_task(std::shared_ptr<reader_type> reader,
+            std::shared_ptr<packer_type> packer,
+            std::shared_ptr<sink_type> sink) :
+            base(std::move(reader), std::move(packer), std::move(sink)) {}
+    };
+
+    namespace details {
+        /// @brief 监视任务的公共循环，只有读取器或来源没有数据时交给空闲策略等待，其余结果重置空闲策略
+        /// @details 包装或拆包失败说明数据已经到达，例如积压链路上的一帧损坏数据，后面可能紧跟着有效数据，应立即重试
+        inline void run_monitored(auto &task, auto &monitor, auto &idle) noexcept {
+            while (true) {
+                const auto result = task.run_once();
+                if (!monitor.handle(result)) return;
+                if (result == reader_failure || result == source_failure) idle.idle();
+                else idle.reset();
+            }
+        }
+    }
+
+    /// @tparam idle_type 空闲策略，默认 @c no_idle 不做任何等待，与原有行为相同
     template<
         is_byte_reader reader_type,
-        is_byte_packer packer_type,
+        is_task_packer packer_type,
         is_item_sink sink_type,
-        is_result_monitor monitor_type>
+        is_result_monitor monitor_type,
+        is_idle_policy idle_type = no_idle,
+        is_task_metrics metrics_type = no_metrics>
     class monitored_reader_task {
-        reader_task<reader_type, packer_type, sink_type> task;
+        reader_task<reader_type, packer_type, sink_type, metrics_type> task;
         std::shared_ptr<monitor_type> monitor;
+        [[no_unique_address]] idle_type idle;
 
     public:
         monitored_reader_task(std::shared_ptr<reader_type> reader,
             std::shared_ptr<packer_type> packer,
-            std::shared_ptr<sink_type> sink, std::shared_ptr<monitor_type> monitor) :
-            task(reader, packer, sink), monitor(monitor) {}
+            std::shared_ptr<sink_type> sink, std::shared_ptr<monitor_type> monitor,
+            idle_type idle = {}) :
+            task(reader, packer, sink), monitor(monitor), idle(std::move(idle)) {}
 
-        void run() noexcept { while (monitor->handle(task.run_once())); }
+        void run() noexcept { details::run_monitored(task, *monitor, idle); }
 
         void operator()() noexcept { run(); }
+
+        [[nodiscard]] const auto &get_task() const noexcept { return task; }
     };
 
+    /// @brief 写入流水线：get → unpack → write ，与 @c reader_pipeline 对称
+    /// @tparam metrics_type 任务度量，默认 @c no_metrics 在编译期消除，使用 @c task_metrics 时记录 get、unpack、write 三个阶段的耗时
     template<
-        typename writer_type,
-        typename unpacker_type,
-        typename source_type>
+        typename writer_stage,
+        typename unpacker_stage,
+        typename source_stage,
+        typename metrics_type = no_metrics,
+        typename writer_type = details::stage_object_t<writer_stage>,
+        typename unpacker_type = details::stage_object_t<unpacker_stage>,
+        typename source_type = details::stage_object_t<source_stage>>
         requires (std::is_same_v<typename unpacker_type::item_type, typename source_type::item_type>)
                  && is_byte_writer<writer_type>
-                 && is_item_unpacker<unpacker_type>
+                 && is_task_unpacker<unpacker_type>
                  && is_item_source<source_type>
-    class writer_task {
+                 && is_task_metrics<metrics_type>
+    class writer_pipeline {
         using item_type = typename source_type::item_type;
-        std::shared_ptr<writer_type> writer;
-        std::shared_ptr<unpacker_type> unpacker;
-        std::shared_ptr<source_type> source;
-        byte_array<sizeof(item_type)> buffer;
-        item_type item;
+        static constexpr bool is_inplace = is_inplace_unpacker<unpacker_type>;
+
+        [[no_unique_address]] writer_stage writer;
+        [[no_unique_address]] unpacker_stage unpacker;
+        [[no_unique_address]] source_stage source;
+        [[no_unique_address]] details::task_storage<item_type, !is_inplace> storage;
+        [[no_unique_address]] metrics_type metrics;
 
     public:
-        writer_task(std::shared_ptr<writer_type> writer,
-            std::shared_ptr<unpacker_type> unpacker,
-            std::shared_ptr<source_type> source) :
-            writer(writer), unpacker(unpacker), source(source) {}
+        writer_pipeline(writer_stage writer, unpacker_stage unpacker, source_stage source) :
+            writer(std::move(writer)), unpacker(std::move(unpacker)), source(std::move(source)) {}
 
+        /// @note 拆包器满足 @c is_inplace_unpacker 时，编译期选择原地流程，来源直接写入拆包器内部的包裹
         int run_once() noexcept {
-            if (!source->get(item)) return source_failure;
-            if (!unpacker->unpack(item, buffer)) return unpacker_failure;
-            if (!writer->write(buffer)) return writer_failure;
+            auto &writer = get_writer();
+            auto &unpacker = get_unpacker();
+            auto &source = get_source();
+            auto stamp = metrics.start();
+            if constexpr (is_inplace) {
+                if (!source.get(unpacker.as_item())) return metrics.fail(source_failure);
+                metrics.lap(stamp, 0);
+                if (!unpacker.unpack()) return metrics.fail(unpacker_failure);
+                metrics.lap(stamp, 1);
+                const auto buffer = unpacker.as_buffer();
+                if (!writer.write(buffer)) return metrics.fail(writer_failure);
+                metrics.lap(stamp, 2);
+                metrics.done(buffer.size());
+            } else {
+                if (!source.get(storage.item)) return metrics.fail(source_failure);
+                metrics.lap(stamp, 0);
+                if (!unpacker.unpack(storage.item, storage.buffer)) return metrics.fail(unpacker_failure);
+                metrics.lap(stamp, 1);
+                if (!writer.write(storage.buffer)) return metrics.fail(writer_failure);
+                metrics.lap(stamp, 2);
+                metrics.done(storage.buffer.size());
+            }
             return 0;
         }
 
         int operator()() noexcept { return run_once(); }
+
+        [[nodiscard]] writer_type &get_writer() noexcept { return details::get_stage(writer); }
+        [[nodiscard]] unpacker_type &get_unpacker() noexcept { return details::get_stage(unpacker); }
+        [[nodiscard]] source_type &get_source() noexcept { return details::get_stage(source); }
+
+        /// @brief 任务度量，可以在其他线程中调用其 snapshot
+        [[nodiscard]] const metrics_type &get_metrics() const noexcept { return metrics; }
+    };
+
+    /// @brief 组合写入流水线，参数的持有方式与 @c pipeline 相同
+    template<typename metrics_type = no_metrics, typename source_stage, typename unpacker_stage, typename writer_stage>
+    [[nodiscard]] auto write_pipeline(source_stage &&source, unpacker_stage &&unpacker, writer_stage &&writer) {
+        return writer_pipeline<std::decay_t<writer_stage>, std::decay_t<unpacker_stage>, std::decay_t<source_stage>, metrics_type>{
+            std::forward<writer_stage>(writer), std::forward<unpacker_stage>(unpacker), std::forward<source_stage>(source)
+        };
+    }
+
+    /// @brief 以 std::shared_ptr 持有各阶段的写入任务，是 @c writer_pipeline 的适配形式
+    template<
+        typename writer_type,
+        typename unpacker_type,
+        typename source_type,
+        typename metrics_type = no_metrics>
+        requires (std::is_same_v<typename unpacker_type::item_type, typename source_type::item_type>)
+                 && is_byte_writer<writer_type>
+                 && is_task_unpacker<unpacker_type>
+                 && is_item_source<source_type>
+                 && is_task_metrics<metrics_type>
+    class writer_task : public writer_pipeline<
+            std::shared_ptr<writer_type>, std::shared_ptr<unpacker_type>, std::shared_ptr<source_type>, metrics_type> {
+        using base = writer_pipeline<
+            std::shared_ptr<writer_type>, std::shared_ptr<unpacker_type>, std::shared_ptr<source_type>, metrics_type>;
+
+    public:
+        writer_task(std::shared_ptr<writer_type> writer,
+            std::shared_ptr<unpacker_type> unpacker,
+            std::shared_ptr<source_type> source) :
+            base(std::move(writer), std::move(unpacker), std::move(source)) {}
     };
 
+    /// @tparam idle_type 空闲策略，来源为空时等待，使用 @c parking_idle 时生产者应通过 @c waking_sink 写入
     template<
         is_item_source source_type,
         is_byte_writer writer_type,
-        is_item_unpacker unpacker_type,
-        is_result_monitor monitor_type>
+        is_task_unpacker unpacker_type,
+        is_result_monitor monitor_type,
+        is_idle_policy idle_type = no_idle,
+        is_task_metrics metrics_type = no_metrics>
     class monitored_writer_task {
-        writer_task<writer_type, unpacker_type, source_type> task;
+        writer_task<writer_type, unpacker_type, source_type, metrics_type> task;
         std::shared_ptr<monitor_type> monitor;
+        [[no_unique_address]] idle_type idle;
 
     public:
         monitored_writer_task(std::shared_ptr<writer_type> writer,
             std::shared_ptr<unpacker_type> unpacker,
-            std::shared_ptr<source_type> source, std::shared_ptr<monitor_type> monitor) :
-            task(writer, unpacker, source), monitor(monitor) {}
+            std::shared_ptr<source_type> source, std::shared_ptr<monitor_type> monitor,
+            idle_type idle = {}) :
+            task(writer, unpacker, source), monitor(monitor), idle(std::move(idle)) {}
 
-        void run() noexcept { while (monitor->handle(task.run_once())); }
+        void run() noexcept { details::run_monitored(task, *monitor, idle); }
         void operator()() noexcept { run(); }
+
+        [[nodiscard]] const auto &get_task() const noexcept { return task; }
     };
 }
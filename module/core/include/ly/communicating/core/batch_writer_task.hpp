@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "basic_bytes.hpp"
+#include "basic_tasks.hpp"
+#include "cpu_hint.hpp"
+
+namespace ly::communicating {
+    /// @brief 批量写入任务，一次写入多个数据包，减少系统调用次数
+    /// @details
+    ///		从来源取出第一个数据后开始计时，继续取出数据直到达到 max_batch 个或超过 max_delay，
+    ///		所有数据依次拆包到同一块连续内存中，最后只调用一次 writer->write。
+    ///		max_delay 为 0 时只收集已经就绪的数据，不会额外等待。
+    ///		等待后续数据时先忙等 spin_count 次，之后每次休眠 poll_interval （不超过剩余时间）再检查来源，
+    ///		串口等毫秒级的 max_delay 不会占满一个核心。
+    /// @tparam max_batch 一次写入的最大数据包数量
+    template<
+        typename writer_type,
+        typename unpacker_type,
+        typename source_type,
+        size_type max_batch>
+        requires (std::is_same_v<typename unpacker_type::item_type, typename source_type::item_type>)
+                 && is_byte_writer<writer_type>
+                 && is_item_unpacker<unpacker_type>
+                 && is_item_source<source_type>
+                 && (max_batch > 0)
+    class batch_writer_task {
+        using item_type = typename source_type::item_type;
+        using clock_type = std::chrono::steady_clock;
+
+        static constexpr size_type item_size = sizeof(item_type);
+
+        std::shared_ptr<writer_type> writer;
+        std::shared_ptr<unpacker_type> unpacker;
+        std::shared_ptr<source_type> source;
+        std::chrono::nanoseconds max_delay;
+        std::chrono::nanoseconds poll_interval;
+
+        byte_array<item_size * max_batch> buffer{};
+        item_type item{};
+
+        std::atomic<size_type> frames{0};
+        std::atomic<size_type> writes{0};
+
+        static constexpr size_type spin_count = 64;
+
+        /// @brief 在 deadline 之前等待来源中的下一个数据
+        bool wait_next(const clock_type::time_point deadline) noexcept {
+            for (size_type spins{0};; ++spins) {
+                if (source->get(item)) return true;
+                const auto now = clock_type::now();
+                if (now >= deadline) return false;
+                if (spins < spin_count) cpu_relax();
+                else std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(deadline - now, poll_interval));
+            }
+        }
+
+    public:
+        /// @param max_delay 收集一批数据最多等待的时间
+        /// @param poll_interval 忙等之后检查来源的间隔，越小批次的截止时间越准确，占用的 CPU 也越多
+        batch_writer_task(std::shared_ptr<writer_type> writer,
+            std::shared_ptr<unpacker_type> unpacker,
+            std::shared_ptr<source_type> source,
+            const std::chrono::nanoseconds max_delay = {},
+            const std::chrono::nanoseconds poll_interval = std::chrono::microseconds{50}) :
+            writer(writer), unpacker(unpacker), source(source), max_delay(max_delay), poll_interval(poll_interval) {}
+
+        /// @note 拆包失败时，仍然写入此前已经拆包的数据，然后返回 unpacker_failure
+        int run_once() noexcept {
+            if (!source->get(item)) return source_failure;
+            const auto deadline = clock_type::now() + max_delay;
+
+            size_type count{0};
+            int result{0};
+            while (true) {
+                if (!unpacker->unpack(item, byte_span{buffer}.subspan(count * item_size, item_size))) {
+                    result = unpacker_failure;
+                    break;
+                }
+                if (++count == max_batch) break;
+
+                if (!wait_next(deadline)) break;
+            }
+
+            if (count == 0) return result;
+            if (!writer->write(byte_span{buffer.data(), count * item_size})) return writer_failure;
+            frames.fetch_add(count, std::memory_order_relaxed);
+            writes.fetch_add(1, std::memory_order_relaxed);
+            return result;
+        }
+
+        int operator()() noexcept { return run_once(); }
+
+        /// @brief 已写入的数据包数量
+        [[nodiscard]] size_type frame_count() const noexcept { return frames.load(std::memory_order_relaxed); }
+
+        /// @brief 已调用 write 的次数
+        [[nodiscard]] size_type write_count() const noexcept { return writes.load(std::memory_order_relaxed); }
+
+        /// @brief 平均每次 write 写入的数据包数量
+        [[nodiscard]] double average_frames_per_write() const noexcept {
+            const auto count = write_count();
+            return count == 0 ? 0.0 : static_cast<double>(frame_count()) / static_cast<double>(count);
+        }
+    };
+
+    template<
+        is_byte_writer writer_type,
+        is_item_unpacker unpacker_type,
+        is_item_source source_type,
+        size_type max_batch,
+        is_result_monitor monitor_type,
+        is_idle_policy idle_type = no_idle>
+    class monitored_batch_writer_task {
+        batch_writer_task<writer_type, unpacker_type, source_type, max_batch> task;
+        std::shared_ptr<monitor_type> monitor;
+        [[no_unique_address]] idle_type idle;
+
+    public:
+        monitored_batch_writer_task(std::shared_ptr<writer_type> writer,
+            std::shared_ptr<unpacker_type> unpacker,
+            std::shared_ptr<source_type> source, std::shared_ptr<monitor_type> monitor,
+            const std::chrono::nanoseconds max_delay = {}, idle_type idle = {},
+            const std::chrono::nanoseconds poll_interval = std::chrono::microseconds{50}) :
+            task(writer, unpacker, source, max_delay, poll_interval), monitor(monitor), idle(std::move(idle)) {}
+
+        void run() noexcept { details::run_monitored(task, *monitor, idle); }
+        void operator()() noexcept { run(); }
+
+        [[nodiscard]] const auto &get_task() const noexcept { return task; }
+    };
+}
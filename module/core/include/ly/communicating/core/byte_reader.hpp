@@ -31,15 +31,13 @@ namespace ly::communicating
         { object.get() } -> std::same_as<byte_span>;
     };
 
-    template<template<typename> typename object_type>
-    template<typename package_type>
+    template<template<typename> typename object_type, typename package_type>
     concept packer = requires(object_type<package_type> &object, const_byte_span data, package_type & package)
     {
         { object.pack(data, package) } -> std::same_as<bool>;
     };
 
-    template<template<typename> typename object_type>
-    template<typename package_type>
+    template<template<typename> typename object_type, typename package_type>
     concept package_destination = requires(object_type<package_type> &object, const package_type & package)
     {
         { object.set(package) };
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include "basic_bytes.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LY_COMMUNICATING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+// 32 位 x86 不保证支持 SSE2 ，只有编译目标已经包含 SSE2 时才使用 SSE2 实现，否则在没有 AVX2 时回退到逐字节比较
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LY_COMMUNICATING_SSE2 1
+#endif
+#endif
+
+namespace ly::communicating {
+    /// @brief 一次扫描的字节数，同时也是 @c byte_mask64 返回的掩码位数
+    constexpr size_type byte_scan_block = 64;
+
+    namespace details {
+        using byte_mask_function = std::uint64_t(*)(const byte_type *, byte_type);
+
+        [[nodiscard]] inline std::uint64_t byte_mask64_scalar(const byte_type *data, const byte_type value) noexcept {
+            std::uint64_t mask{0};
+            for (size_type i = 0; i < byte_scan_block; ++i)
+                mask |= static_cast<std::uint64_t>(data[i] == value) << i;
+            return mask;
+        }
+
+#if LY_COMMUNICATING_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define LY_COMMUNICATING_TARGET(name) __attribute__((target(name)))
+#else
+#define LY_COMMUNICATING_TARGET(name)
+#endif
+
+#if LY_COMMUNICATING_SSE2
+        LY_COMMUNICATING_TARGET("sse2")
+        [[nodiscard]] inline std::uint64_t byte_mask64_sse2(const byte_type *data, const byte_type value) noexcept {
+            const auto needle = _mm_set1_epi8(static_cast<char>(value));
+            std::uint64_t mask{0};
+            for (size_type i = 0; i < byte_scan_block; i += 16) {
+                const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                const auto bits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+                mask |= static_cast<std::uint64_t>(bits) << i;
+            }
+            return mask;
+        }
+#endif
+
+        LY_COMMUNICATING_TARGET("avx2")
+        [[nodiscard]] inline std::uint64_t byte_mask64_avx2(const byte_type *data, const byte_type value) noexcept {
+            const auto needle = _mm256_set1_epi8(static_cast<char>(value));
+            const auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            const auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+            const auto low_bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+            const auto high_bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+            return static_cast<std::uint64_t>(high_bits) << 32 | low_bits;
+        }
+
+#undef LY_COMMUNICATING_TARGET
+
+        [[nodiscard]] inline bool cpu_supports_avx2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4]{};
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            return os_saves_ymm && (info[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        /// @brief 运行时根据 CPU 特性选择实现，结果在首次调用时确定
+        [[nodiscard]] inline byte_mask_function select_byte_mask64() noexcept {
+#if LY_COMMUNICATING_X86
+            if (cpu_supports_avx2()) return byte_mask64_avx2;
+#if LY_COMMUNICATING_SSE2
+            return byte_mask64_sse2;
+#else
+            return byte_mask64_scalar;
+#endif
+#else
+            return byte_mask64_scalar;
+#endif
+        }
+
+        [[nodiscard]] inline byte_mask_function byte_mask64_dispatch() noexcept {
+            static const auto function = select_byte_mask64();
+            return function;
+        }
+    }
+
+    /// @brief 计算 data 开始的 size 个字节中等于 value 的位置掩码，第 i 位对应 data[i]
+    /// @param size 参与扫描的字节数，超过 64 的部分将被忽略
+    [[nodiscard]] inline std::uint64_t byte_mask64(const byte_type *data, const size_type size,
+        const byte_type value) noexcept {
+        const auto function = details::byte_mask64_dispatch();
+        if (size >= byte_scan_block) return function(data, value);
+        if (size == 0) return 0;
+
+        // 不足一个块时拷贝到栈上，避免越界读取
+        byte_array<byte_scan_block> block{};
+        std::memcpy(block.data(), data, size);
+        return function(block.data(), value) & ((std::uint64_t{1} << size) - 1);
+    }
+
+    /// @brief 查找第一个等于 value 的字节
+    /// @return 字节的下标，找不到时返回 span.size()
+    /// @note
+    ///		不足一个块的短区间逐字节比较，避免拷贝到栈上再整块读取造成的存储转发停顿；
+    ///		较长区间的末尾不足一个块时，回退到末尾整块读取，与已扫描的部分重叠
+    [[nodiscard]] inline size_type find_byte(const const_byte_span span, const byte_type value) noexcept {
+        const auto *data = span.data();
+        const auto size = span.size();
+        if (size < byte_scan_block) {
+            for (size_type i = 0; i < size; ++i)
+                if (data[i] == value) return i;
+            return size;
+        }
+        const auto function = details::byte_mask64_dispatch();
+        size_type offset{0};
+        for (; offset + byte_scan_block <= size; offset += byte_scan_block)
+            if (const auto mask = function(data + offset, value); mask != 0) return offset + std::countr_zero(mask);
+        if (offset < size) {
+            const auto last = size - byte_scan_block;
+            if (const auto mask = function(data + last, value) >> (offset - last); mask != 0)
+                return offset + std::countr_zero(mask);
+        }
+        return size;
+    }
+
+    /// @brief 记录 span 中所有等于 value 的字节下标
+    /// @param offsets 用于输出下标，写满后停止扫描
+    /// @return 写入 offsets 的下标数量
+    [[nodiscard]] inline size_type scan_bytes(const const_byte_span span, const byte_type value,
+        const std::span<size_type> offsets) noexcept {
+        size_type count{0};
+        for (size_type offset = 0; offset < span.size() && count < offsets.size(); offset += byte_scan_block) {
+            for (auto mask = byte_mask64(span.data() + offset, span.size() - offset, value);
+                 mask != 0 && count < offsets.size(); mask &= mask - 1)
+                offsets[count++] = offset + std::countr_zero(mask);
+        }
+        return count;
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <optional>
+
+#include "basic_bytes.hpp"
+#include "basic_tasks.hpp"
+#include "byte_scan.hpp"
+
+namespace ly::communicating {
+    /// @brief COBS 编码后的最大长度，不含帧尾的 0 字节
+    [[nodiscard]] constexpr size_type cobs_max_encoded_size(const size_type size) noexcept {
+        return size + size / 254 + 1;
+    }
+
+    /// @brief COBS 编码，输出中不含 0 字节，调用者在末尾追加一个 0 作为帧分隔符
+    /// @details 每个分组通过 @c find_byte 以 SIMD 查找下一个 0 ，分组内的字节整段拷贝
+    /// @return 编码后的长度，output 不足 @c cobs_max_encoded_size 且放不下时返回 std::nullopt
+    [[nodiscard]] inline std::optional<size_type> cobs_encode(const const_byte_span input, const byte_span output) noexcept {
+        size_type in{0};
+        size_type out{0};
+        while (true) {
+            const auto limit = std::min<size_type>(254, input.size() - in);
+            const auto run = find_byte(input.subspan(in, limit), 0);
+            if (out + 1 + run > output.size()) return std::nullopt;
+            output[out] = static_cast<byte_type>(run + 1);
+            std::memcpy(output.data() + out + 1, input.data() + in, run);
+            out += run + 1;
+            in += run;
+            // 满 254 字节的分组之后没有隐含的 0 ，其余分组之后跳过输入中的 0
+            if (run == 254) continue;
+            if (in == input.size()) return out;
+            ++in;
+        }
+    }
+
+    /// @brief COBS 解码一个完整的帧，input 不含帧尾的 0 字节
+    /// @return 解码后的长度，帧中出现 0 、分组越界或 output 不足时返回 std::nullopt
+    [[nodiscard]] inline std::optional<size_type> cobs_decode(const const_byte_span input, const byte_span output) noexcept {
+        if (input.empty() || find_byte(input, 0) != input.size()) return std::nullopt;
+        size_type in{0};
+        size_type out{0};
+        while (in < input.size()) {
+            const size_type code = input[in];
+            const auto run = code - 1;
+            if (in + code > input.size() || out + run > output.size()) return std::nullopt;
+            std::memcpy(output.data() + out, input.data() + in + 1, run);
+            out += run;
+            in += code;
+            if (code != 0xFF && in < input.size()) {
+                if (out == output.size()) return std::nullopt;
+                output[out++] = 0;
+            }
+        }
+        return out;
+    }
+
+    /// @brief 以 0 字节分隔的 COBS 数据流解码器，可以在任意位置切分输入
+    /// @details
+    ///		分隔符通过 SIMD 查找，分隔符之间按分组整段拷贝。任何 0 字节都是帧边界，
+    ///		因此负载内容不会造成误同步，损坏的帧只影响到下一个 0 为止，不需要回退重新扫描。
+    ///		截断、超长或分组不完整的帧会被丢弃并计入 @c get_error_count 。
+    /// @tparam max_frame_size 解码后单帧的最大长度
+    template<size_type max_frame_size>
+    class cobs_stream_decoder final {
+        byte_array<max_frame_size> frame{};
+        size_type frame_size{0};
+
+        /// @brief 当前分组中还需要拷贝的字节数
+        size_type remaining{0};
+        /// @brief 当前分组结束后是否需要补一个 0 ，由分组的编码字节决定
+        bool zero_after_group{false};
+        /// @brief 自上一个分隔符起是否读到过字节
+        bool started{false};
+        bool overflow{false};
+
+        size_type error_count{0};
+
+        void reset() noexcept {
+            frame_size = remaining = 0;
+            zero_after_group = started = overflow = false;
+        }
+
+        void append(const byte_type *data, const size_type size) noexcept {
+            if (overflow || frame_size + size > max_frame_size) {
+                overflow = true;
+                return;
+            }
+            std::memcpy(frame.data() + frame_size, data, size);
+            frame_size += size;
+        }
+
+        /// @brief 处理两个分隔符之间的一段字节，其中不含 0
+        void consume(const_byte_span segment) noexcept {
+            while (!segment.empty()) {
+                if (remaining == 0) {
+                    if (started && zero_after_group) {
+                        constexpr byte_type zero{0};
+                        append(&zero, 1);
+                    }
+                    started = true;
+                    remaining = segment.front() - 1;
+                    zero_after_group = segment.front() != 0xFF;
+                    segment = segment.subspan(1);
+                    continue;
+                }
+                const auto bytes = std::min(remaining, segment.size());
+                append(segment.data(), bytes);
+                remaining -= bytes;
+                segment = segment.subspan(bytes);
+            }
+        }
+
+    public:
+        static constexpr auto MaxFrameSize = max_frame_size;
+
+        /// @brief 解码任意长度的字节块，每遇到一个分隔符就输出一个完整的帧
+        /// @param on_frame 以 const_byte_span 为参数的回调，区间指向解码器内部，仅在回调期间有效
+        /// @return 输出的帧数量
+        template<typename callback_type>
+        size_type feed(const_byte_span chunk, callback_type &&on_frame) {
+            size_type count{0};
+            while (!chunk.empty()) {
+                const auto delimiter = find_byte(chunk, 0);
+                consume(chunk.first(delimiter));
+                if (delimiter == chunk.size()) break;
+                chunk = chunk.subspan(delimiter + 1);
+
+                if (!started) continue;
+                if (remaining != 0 || overflow) ++error_count;
+                else {
+                    on_frame(const_byte_span{frame.data(), frame_size});
+                    ++count;
+                }
+                reset();
+            }
+            return count;
+        }
+
+        /// @brief 被丢弃的帧数量
+        [[nodiscard]] size_type get_error_count() const noexcept { return error_count; }
+
+        void clear() noexcept {
+            reset();
+            error_count = 0;
+        }
+    };
+
+    /// @brief COBS 拆包器，将内部拆包器输出的 raw_size 字节编码为以 0 结尾的帧
+    /// @details 满足 @c is_inplace_unpacker ，输出长度随内容变化，@c as_buffer 返回本次编码的实际长度
+    /// @tparam TUnpacker 满足 @c is_item_unpacker 的拆包器
+    /// @tparam raw_size 编码前的长度，默认为包裹大小
+    template<typename TUnpacker, size_type raw_size = sizeof(typename TUnpacker::item_type)>
+        requires is_item_unpacker<TUnpacker>
+    class cobs_unpacker final {
+    public:
+        using item_type = typename TUnpacker::item_type;
+
+        static constexpr size_type MaxEncodedSize = cobs_max_encoded_size(raw_size) + 1;
+
+    private:
+        std::shared_ptr<TUnpacker> unpacker;
+        item_type item{};
+        byte_array<raw_size> raw{};
+        byte_array<MaxEncodedSize> encoded{};
+        size_type encoded_size{0};
+
+    public:
+        explicit cobs_unpacker(std::shared_ptr<TUnpacker> unpacker) : unpacker(std::move(unpacker)) {}
+
+        [[nodiscard]] item_type &as_item() noexcept { return item; }
+
+        bool unpack() noexcept {
+            if (!unpacker->unpack(item, raw)) return false;
+            const auto size = cobs_encode(raw, encoded);
+            if (!size) return false;
+            encoded[*size] = 0;
+            encoded_size = *size + 1;
+            return true;
+        }
+
+        [[nodiscard]] byte_span as_buffer() noexcept { return {encoded.data(), encoded_size}; }
+    };
+
+    /// @brief COBS 包装器，将一个完整的 COBS 帧解码为 raw_size 字节后交给内部包装器
+    /// @details 满足 @c is_byte_packer ，帧尾的 0 可有可无，通常与 @c cobs_stream_decoder 的输出配合使用
+    /// @tparam TPacker 满足 @c is_byte_packer 的包装器
+    template<typename TPacker, size_type raw_size = sizeof(typename TPacker::item_type)>
+        requires is_byte_packer<TPacker>
+    class cobs_packer final {
+        std::shared_ptr<TPacker> packer;
+        byte_array<raw_size> raw{};
+
+    public:
+        using item_type = typename TPacker::item_type;
+
+        explicit cobs_packer(std::shared_ptr<TPacker> packer) : packer(std::move(packer)) {}
+
+        bool pack(const_byte_span buffer, item_type &item) noexcept {
+            if (!buffer.empty() && buffer.back() == 0) buffer = buffer.first(buffer.size() - 1);
+            const auto size = cobs_decode(buffer, raw);
+            if (!size || *size != raw_size) return false;
+            return packer->pack(raw, item);
+        }
+    };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace ly::communicating {
+    /// @brief 缓存行大小，用于对齐被不同线程频繁写入的数据，避免伪共享
+    /// @note 不使用 std::hardware_destructive_interference_size ，因为它的值会随编译选项变化，不适合出现在接口中
+    constexpr std::size_t cache_line_size = 64;
+
+    /// @brief 自旋等待时提示 CPU 降低功耗并让出流水线资源
+    inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+}
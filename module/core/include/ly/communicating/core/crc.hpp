@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "basic_bytes.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LY_COMMUNICATING_CRC32C_HW 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace ly::communicating {
+    namespace details {
+        /// @brief 将 value 的低 width 位按位反转
+        template<std::unsigned_integral value_type>
+        [[nodiscard]] constexpr value_type reflect_bits(value_type value, const size_type width) noexcept {
+            value_type result{0};
+            for (size_type i = 0; i < width; ++i) {
+                result = static_cast<value_type>((result << 1) | (value & 1));
+                value = static_cast<value_type>(value >> 1);
+            }
+            return result;
+        }
+
+        /// @brief slicing-by-8 查找表，tables[0] 为普通的单字节查找表，tables[k][b] 为字节 b 后接 k 个零字节的余数
+        template<std::unsigned_integral value_type, size_type width, value_type poly, bool reflected>
+        [[nodiscard]] constexpr std::array<std::array<value_type, 256>, 8> make_crc_tables() noexcept {
+            constexpr value_type top = static_cast<value_type>(value_type{1} << (width - 1));
+            constexpr value_type mask = static_cast<value_type>(~value_type{0} >> (sizeof(value_type) * 8 - width));
+            std::array<std::array<value_type, 256>, 8> tables{};
+            for (size_type byte = 0; byte < 256; ++byte) {
+                value_type crc;
+                if constexpr (reflected) {
+                    constexpr auto reversed = reflect_bits(poly, width);
+                    crc = static_cast<value_type>(byte);
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc = static_cast<value_type>((crc & 1) ? (crc >> 1) ^ reversed : crc >> 1);
+                } else {
+                    crc = static_cast<value_type>(static_cast<value_type>(byte) << (width - 8));
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc = static_cast<value_type>((crc & top) ? (crc << 1) ^ poly : crc << 1);
+                }
+                tables[0][byte] = static_cast<value_type>(crc & mask);
+            }
+            for (size_type k = 1; k < 8; ++k)
+                for (size_type byte = 0; byte < 256; ++byte) {
+                    const auto previous = tables[k - 1][byte];
+                    if constexpr (reflected)
+                        tables[k][byte] = static_cast<value_type>(
+                            (width > 8 ? previous >> 8 : 0) ^ tables[0][previous & 0xFF]);
+                    else
+                        tables[k][byte] = static_cast<value_type>(
+                            ((width > 8 ? previous << 8 : 0) ^ tables[0][(previous >> (width - 8)) & 0xFF]) & mask);
+                }
+            return tables;
+        }
+
+        [[nodiscard]] constexpr std::uint64_t byte_swap64(const std::uint64_t word) noexcept {
+            return (word >> 56) | ((word >> 40) & 0xFF00) | ((word >> 24) & 0xFF0000) | ((word >> 8) & 0xFF000000) |
+                ((word & 0xFF000000) << 8) | ((word & 0xFF0000) << 24) | ((word & 0xFF00) << 40) | (word << 56);
+        }
+
+        /// @brief 以大端序读取 8 字节
+        [[nodiscard]] inline std::uint64_t load_big_endian64(const byte_type *data) noexcept {
+            std::uint64_t word;
+            std::memcpy(&word, data, 8);
+            if constexpr (std::endian::native == std::endian::little) word = byte_swap64(word);
+            return word;
+        }
+
+        /// @brief 以小端序读取 8 字节
+        [[nodiscard]] inline std::uint64_t load_little_endian64(const byte_type *data) noexcept {
+            std::uint64_t word;
+            std::memcpy(&word, data, 8);
+            if constexpr (std::endian::native == std::endian::big) word = byte_swap64(word);
+            return word;
+        }
+
+#if LY_COMMUNICATING_CRC32C_HW
+#if defined(__GNUC__) || defined(__clang__)
+#define LY_COMMUNICATING_TARGET(name) __attribute__((target(name)))
+#else
+#define LY_COMMUNICATING_TARGET(name)
+#endif
+
+        /// @brief 使用 SSE4.2 的 crc32 指令计算 CRC32C ，每条指令处理 8 字节
+        LY_COMMUNICATING_TARGET("sse4.2")
+        [[nodiscard]] inline std::uint32_t crc32c_sse42(std::uint32_t crc, const byte_type *data, size_type size) noexcept {
+            std::uint64_t wide = crc;
+            for (; size >= 8; size -= 8, data += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, data, 8);
+                wide = _mm_crc32_u64(wide, word);
+            }
+            crc = static_cast<std::uint32_t>(wide);
+            for (; size > 0; --size, ++data) crc = _mm_crc32_u8(crc, *data);
+            return crc;
+        }
+
+#undef LY_COMMUNICATING_TARGET
+
+        [[nodiscard]] inline bool cpu_supports_sse42() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4]{};
+            __cpuid(info, 1);
+            return info[2] & (1 << 20);
+#else
+            return __builtin_cpu_supports("sse4.2");
+#endif
+        }
+
+        [[nodiscard]] inline bool crc32c_hardware_available() noexcept {
+            static const bool available = cpu_supports_sse42();
+            return available;
+        }
+#endif
+    }
+
+    /// @brief 通用 CRC 算法，查找表在编译期生成
+    /// @details
+    ///		参数与 Rocksoft 模型一致，poly 为不反转的多项式写法。
+    ///		8 张查找表在编译期生成，运行时使用 slicing-by-8 每次处理 8 字节，编译期求值时逐字节查表。
+    ///		数据包末尾的 CRC 以 order 字节序保存，占 width / 8 字节。
+    ///		@c verify 与 @c append 的签名与 @c byte_verifier 一致，可以直接作为解码器的模板参数与拆包器的末尾填充。
+    /// @tparam width CRC 位数，8 、16 或 32
+    template<
+        size_type width,
+        std::uint32_t poly,
+        std::uint32_t init,
+        bool reflected,
+        std::uint32_t xor_out,
+        std::endian order = std::endian::little>
+        requires (width == 8 || width == 16 || width == 32)
+    struct crc_algorithm {
+        using value_type = std::conditional_t<width == 8, std::uint8_t,
+            std::conditional_t<width == 16, std::uint16_t, std::uint32_t>>;
+
+        static constexpr size_type size = width / 8;
+
+        static constexpr auto tables = details::make_crc_tables<value_type, width, static_cast<value_type>(poly), reflected>();
+
+        /// @brief 逐字节查表
+        [[nodiscard]] static constexpr value_type update_bytewise(value_type crc, const const_byte_span data) noexcept {
+            for (const auto byte : data) {
+                if constexpr (reflected)
+                    crc = static_cast<value_type>((width > 8 ? crc >> 8 : 0) ^ tables[0][(crc ^ byte) & 0xFF]);
+                else
+                    crc = static_cast<value_type>((width > 8 ? crc << 8 : 0) ^ tables[0][((crc >> (width - 8)) ^ byte) & 0xFF]);
+            }
+            return crc;
+        }
+
+        /// @brief slicing-by-8 ，每次用 8 次查表处理 8 字节，不足 8 字节的部分逐字节查表
+        [[nodiscard]] static value_type update_sliced(value_type crc, const_byte_span data) noexcept {
+            const auto *bytes = data.data();
+            auto remaining = data.size();
+            for (; remaining >= 8; remaining -= 8, bytes += 8) {
+                if constexpr (reflected) {
+                    // 反转的算法从低位开始，第一个字节位于字的最低位
+                    const auto word = details::load_little_endian64(bytes) ^ crc;
+                    crc = static_cast<value_type>(
+                        tables[7][word & 0xFF] ^ tables[6][(word >> 8) & 0xFF] ^
+                        tables[5][(word >> 16) & 0xFF] ^ tables[4][(word >> 24) & 0xFF] ^
+                        tables[3][(word >> 32) & 0xFF] ^ tables[2][(word >> 40) & 0xFF] ^
+                        tables[1][(word >> 48) & 0xFF] ^ tables[0][word >> 56]);
+                } else {
+                    // 不反转的算法从高位开始，寄存器对齐到 64 位字的最高位
+                    const auto word = details::load_big_endian64(bytes) ^ (std::uint64_t{crc} << (64 - width));
+                    crc = static_cast<value_type>(
+                        tables[7][word >> 56] ^ tables[6][(word >> 48) & 0xFF] ^
+                        tables[5][(word >> 40) & 0xFF] ^ tables[4][(word >> 32) & 0xFF] ^
+                        tables[3][(word >> 24) & 0xFF] ^ tables[2][(word >> 16) & 0xFF] ^
+                        tables[1][(word >> 8) & 0xFF] ^ tables[0][word & 0xFF]);
+                }
+            }
+            return update_bytewise(crc, data.last(remaining));
+        }
+
+        /// @brief 在已有的中间值上继续计算，可用于分段输入，中间值从 @c initial 开始，最后通过 @c finalize 得到结果
+        [[nodiscard]] static constexpr value_type update(const value_type crc, const const_byte_span data) noexcept {
+            if (std::is_constant_evaluated()) return update_bytewise(crc, data);
+#if LY_COMMUNICATING_CRC32C_HW
+            // CRC32C 在支持 SSE4.2 的 CPU 上使用硬件指令
+            if constexpr (width == 32 && poly == 0x1EDC6F41 && reflected)
+                if (details::crc32c_hardware_available())
+                    return details::crc32c_sse42(crc, data.data(), data.size());
+#endif
+            return update_sliced(crc, data);
+        }
+
+        [[nodiscard]] static constexpr value_type initial() noexcept {
+            return reflected ? details::reflect_bits(static_cast<value_type>(init), width) : static_cast<value_type>(init);
+        }
+
+        [[nodiscard]] static constexpr value_type finalize(const value_type crc) noexcept {
+            return static_cast<value_type>(crc ^ static_cast<value_type>(xor_out));
+        }
+
+        [[nodiscard]] static constexpr value_type compute(const const_byte_span data) noexcept {
+            return finalize(update(initial(), data));
+        }
+
+        /// @brief 检验数据包末尾 size 字节是否为前面所有字节的 CRC
+        [[nodiscard]] static bool verify(const const_byte_span frame) noexcept {
+            if (frame.size() <= size) return false;
+            return compute(frame.first(frame.size() - size)) == load(frame.last(size));
+        }
+
+        /// @brief 计算数据包除末尾 size 字节外所有字节的 CRC ，并写入末尾
+        static void append(const byte_span frame) noexcept {
+            if (frame.size() <= size) return;
+            store(compute(frame.first(frame.size() - size)), frame.last(size));
+        }
+
+    private:
+        [[nodiscard]] static value_type load(const const_byte_span bytes) noexcept {
+            value_type value{0};
+            for (size_type i = 0; i < size; ++i) {
+                const auto shift = order == std::endian::little ? i * 8 : (size - 1 - i) * 8;
+                value = static_cast<value_type>(value | static_cast<value_type>(bytes[i]) << shift);
+            }
+            return value;
+        }
+
+        static void store(const value_type value, const byte_span bytes) noexcept {
+            for (size_type i = 0; i < size; ++i) {
+                const auto shift = order == std::endian::little ? i * 8 : (size - 1 - i) * 8;
+                bytes[i] = static_cast<byte_type>(value >> shift);
+            }
+        }
+    };
+
+    /// @brief CRC-8/SMBUS ，多项式 0x07
+    using crc8_smbus = crc_algorithm<8, 0x07, 0x00, false, 0x00>;
+    /// @brief CRC-8/MAXIM-DOW ，多项式 0x31 ，输入输出反转
+    using crc8_maxim = crc_algorithm<8, 0x31, 0x00, true, 0x00>;
+    /// @brief CRC-16/CCITT-FALSE （IBM-3740），多项式 0x1021 ，初值 0xFFFF ，不反转
+    using crc16_ccitt_false = crc_algorithm<16, 0x1021, 0xFFFF, false, 0x0000>;
+    /// @brief CRC-16/MCRF4XX ，多项式 0x1021 ，初值 0xFFFF ，输入输出反转
+    using crc16_mcrf4xx = crc_algorithm<16, 0x1021, 0xFFFF, true, 0x0000>;
+    /// @brief CRC-16/MODBUS ，多项式 0x8005 ，初值 0xFFFF ，输入输出反转
+    using crc16_modbus = crc_algorithm<16, 0x8005, 0xFFFF, true, 0x0000>;
+    /// @brief CRC-32 （IEEE 802.3）
+    using crc32 = crc_algorithm<32, 0x04C11DB7, 0xFFFFFFFF, true, 0xFFFFFFFF>;
+    /// @brief CRC-32C （Castagnoli），x86-64 上支持 SSE4.2 时使用硬件指令
+    using crc32c = crc_algorithm<32, 0x1EDC6F41, 0xFFFFFFFF, true, 0xFFFFFFFF>;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include "basic_bytes.hpp"
+#include "basic_tasks.hpp"
+#include "cobs.hpp"
+#include "crc.hpp"
+#include "typed_message.hpp"
+
+namespace ly::communicating {
+    /// @brief 差分帧的布局，帧在线路上以 COBS 编码并以 0 结尾
+    /// @details
+    ///		关键帧：type 、0x80 | key_id 高 7 位、key_id 低 8 位、完整数据区、校验；
+    ///		差分帧：type 、key_id 高 7 位、key_id 低 8 位、变化字节的位图（第 i 位对应数据区第 i 字节）、按顺序排列的变化字节、校验。
+    ///		key_id 是关键帧的编号，按消息类型各自递增，取 15 位；差分帧携带其基准关键帧的 key_id ，
+    ///		接收端据此拒绝基准已经丢失的差分帧，同一类型连续丢失 32768 个关键帧才会认错基准。
+    ///		typed_message 的 head 与 tail 是固定值，不在线路上传输，由接收端填回。
+    /// @tparam data_size 消息数据区大小
+    /// @tparam check 整帧校验，@c crc_algorithm 或其他提供 size 、verify 与 append 的类型
+    template<size_type data_size, typename check = crc8_smbus>
+    struct delta_frame_layout {
+        static constexpr size_type MaskSize = (data_size + 7) / 8;
+        static constexpr size_type HeaderSize = 3;
+        static constexpr size_type KeyframeSize = HeaderSize + data_size + check::size;
+        /// @brief 差分帧不会比关键帧长，更长时改发关键帧
+        static constexpr size_type MaxFrameSize = KeyframeSize;
+        static constexpr size_type MaxEncodedSize = cobs_max_encoded_size(MaxFrameSize) + 1;
+
+        static constexpr byte_type KeyframeFlag = 0x80;
+        static constexpr std::uint16_t KeyIdMask = 0x7FFF;
+
+        static void write_header(byte_type *raw, const byte_type type, const bool keyframe, const std::uint16_t key_id) noexcept {
+            raw[0] = type;
+            raw[1] = static_cast<byte_type>((keyframe ? KeyframeFlag : 0) | key_id >> 8);
+            raw[2] = static_cast<byte_type>(key_id);
+        }
+
+        [[nodiscard]] static std::uint16_t read_key_id(const const_byte_span header) noexcept {
+            return static_cast<std::uint16_t>((header[1] & 0x7F) << 8 | header[2]);
+        }
+    };
+
+    namespace details {
+        /// @brief 比较两段数据区，写出变化字节的位图，返回变化的字节数
+        /// @details 每 8 字节先整字比较，相同则整段跳过，控制量通常只有少数字段变化
+        template<size_type data_size>
+        size_type diff_mask(const byte_type *current, const byte_type *last, byte_type *mask) noexcept {
+            size_type changed{0};
+            size_type i{0};
+            for (; i + 8 <= data_size; i += 8) {
+                std::uint64_t a, b;
+                std::memcpy(&a, current + i, 8);
+                std::memcpy(&b, last + i, 8);
+                byte_type bits{0};
+                if (a != b)
+                    for (size_type j = 0; j < 8; ++j)
+                        if (current[i + j] != last[i + j]) bits = static_cast<byte_type>(bits | 1u << j);
+                mask[i / 8] = bits;
+                changed += static_cast<size_type>(std::popcount(bits));
+            }
+            if constexpr (data_size % 8 != 0) {
+                byte_type bits{0};
+                for (size_type j = 0; i + j < data_size; ++j)
+                    if (current[i + j] != last[i + j]) bits = static_cast<byte_type>(bits | 1u << j);
+                mask[i / 8] = bits;
+                changed += static_cast<size_type>(std::popcount(bits));
+            }
+            return changed;
+        }
+    }
+
+    /// @brief 差分拆包器，按消息类型记住上次发出的关键帧，只发送相对关键帧变化的字节
+    /// @details
+    ///		满足 @c is_inplace_unpacker ，可以直接替换 @c writer_task 中发送完整 @c typed_message 的拆包器，
+    ///		输出以 COBS 编码并以 0 结尾，长度随变化的字节数而变化，@c as_buffer 返回本次的实际长度。
+    ///		差分帧都以最近的关键帧为基准，彼此独立：丢失一个差分帧只影响这一帧，丢失关键帧时影响到下一个关键帧为止。
+    ///		每种类型第一次发送、距上次关键帧满 keyframe_interval 帧、或差分帧不比关键帧短时发送关键帧，
+    ///		数据持续变化时差分帧逐渐变长，会自动改发关键帧。
+    ///		接收端使用 @c cobs_stream_decoder 切分帧，再交给 @c delta_packer 重建完整的消息。
+    /// @tparam data_size 消息数据区大小
+    /// @tparam check 整帧校验
+    template<size_type data_size, typename check = crc8_smbus>
+    class delta_unpacker final {
+    public:
+        using item_type = typed_message<data_size>;
+        using layout = delta_frame_layout<data_size, check>;
+
+    private:
+        struct type_state {
+            byte_array<data_size> key{};
+            size_type since_keyframe{0};
+            std::uint16_t key_id{0};
+            bool sent{false};
+            bool force_keyframe{false};
+        };
+
+        std::array<type_state, 256> states{};
+        size_type keyframe_interval;
+        item_type item{};
+        byte_array<layout::MaxFrameSize> raw{};
+        byte_array<layout::MaxEncodedSize> encoded{};
+        size_type encoded_size{0};
+        size_type keyframe_count{0};
+        size_type delta_count{0};
+
+    public:
+        static constexpr auto MaxEncodedSize = layout::MaxEncodedSize;
+
+        /// @param keyframe_interval 每种类型两次关键帧之间最多的差分帧数量，0 表示每帧都发送关键帧
+        explicit delta_unpacker(const size_type keyframe_interval = 32) noexcept : keyframe_interval(keyframe_interval) {}
+
+        [[nodiscard]] item_type &as_item() noexcept { return item; }
+
+        bool unpack() noexcept {
+            auto &state = states[item.type];
+            size_type size{0};
+
+            auto keyframe = !state.sent || state.force_keyframe || state.since_keyframe >= keyframe_interval;
+            if (!keyframe) {
+                const auto mask = raw.data() + layout::HeaderSize;
+                const auto changed = details::diff_mask<data_size>(item.data.data(), state.key.data(), mask);
+                size = layout::HeaderSize + layout::MaskSize + changed + check::size;
+                if (size >= layout::KeyframeSize) keyframe = true;
+                else {
+                    auto output = mask + layout::MaskSize;
+                    for (size_type i = 0; i < data_size; ++i)
+                        if (mask[i / 8] >> (i % 8) & 1) *output++ = item.data[i];
+                    layout::write_header(raw.data(), item.type, false, state.key_id);
+                    ++state.since_keyframe;
+                    ++delta_count;
+                }
+            }
+            if (keyframe) {
+                size = layout::KeyframeSize;
+                if (state.sent) state.key_id = static_cast<std::uint16_t>((state.key_id + 1) & layout::KeyIdMask);
+                layout::write_header(raw.data(), item.type, true, state.key_id);
+                std::memcpy(raw.data() + layout::HeaderSize, item.data.data(), data_size);
+                state.key = item.data;
+                state.since_keyframe = 0;
+                state.sent = true;
+                state.force_keyframe = false;
+                ++keyframe_count;
+            }
+            check::append({raw.data(), size});
+
+            const auto encoded_length = cobs_encode({raw.data(), size}, encoded);
+            if (!encoded_length) return false;
+            encoded[*encoded_length] = 0;
+            encoded_size = *encoded_length + 1;
+            return true;
+        }
+
+        [[nodiscard]] byte_span as_buffer() noexcept { return {encoded.data(), encoded_size}; }
+
+        /// @brief 让该类型的下一帧发送关键帧，例如得知接收端重启时
+        /// @note 新关键帧的 key_id 照常递增，即使它丢失，接收端也不会把之后的差分帧应用到旧关键帧上
+        void request_keyframe(const byte_type type) noexcept { states[type].force_keyframe = true; }
+
+        [[nodiscard]] size_type get_keyframe_count() const noexcept { return keyframe_count; }
+        [[nodiscard]] size_type get_delta_count() const noexcept { return delta_count; }
+    };
+
+    /// @brief 差分包装器，将 @c delta_unpacker 发出的差分帧应用到按类型保存的关键帧上，重建完整的消息
+    /// @details
+    ///		满足 @c is_byte_packer ，输入是 @c cobs_stream_decoder 解码后的帧，不含帧尾的 0 。
+    ///		校验失败的帧计入 @c get_error_count ；某类型还没有收到关键帧、或差分帧的 key_id 与保存的关键帧不一致时，
+    ///		该差分帧无法应用，丢弃并计入 @c get_resync_count ，之后的差分帧不受影响。
+    /// @tparam data_size 消息数据区大小
+    /// @tparam check 整帧校验，与发送端一致
+    template<size_type data_size, typename check = crc8_smbus>
+    class delta_packer final {
+    public:
+        using item_type = typed_message<data_size>;
+        using layout = delta_frame_layout<data_size, check>;
+
+    private:
+        struct type_state {
+            byte_array<data_size> key{};
+            std::uint16_t key_id{0};
+            bool synced{false};
+        };
+
+        std::array<type_state, 256> states{};
+        byte_type head;
+        byte_type tail;
+        size_type error_count{0};
+        size_type resync_count{0};
+
+        bool fail() noexcept {
+            ++error_count;
+            return false;
+        }
+
+        bool apply_delta(const const_byte_span body, byte_array<data_size> &data) noexcept {
+            if (body.size() < layout::MaskSize) return fail();
+            const auto mask = body.first(layout::MaskSize);
+            size_type changed{0};
+            for (const auto bits : mask) changed += static_cast<size_type>(std::popcount(bits));
+            if constexpr (data_size % 8 != 0)
+                if (mask.back() >> (data_size % 8) != 0) return fail();
+            if (body.size() != layout::MaskSize + changed) return fail();
+
+            auto input = body.data() + layout::MaskSize;
+            for (size_type i = 0; i < data_size; ++i)
+                if (mask[i / 8] >> (i % 8) & 1) data[i] = *input++;
+            return true;
+        }
+
+    public:
+        /// @param head 重建消息的 head 字节
+        /// @param tail 重建消息的 tail 字节
+        delta_packer(const byte_type head, const byte_type tail) noexcept : head(head), tail(tail) {}
+
+        bool pack(const const_byte_span buffer, item_type &item) noexcept {
+            if (buffer.size() < layout::HeaderSize + check::size || !check::verify(buffer)) return fail();
+
+            const auto type = buffer[0];
+            const auto key_id = layout::read_key_id(buffer);
+            const auto body = buffer.subspan(layout::HeaderSize, buffer.size() - layout::HeaderSize - check::size);
+            auto &state = states[type];
+
+            if (buffer[1] & layout::KeyframeFlag) {
+                if (body.size() != data_size) return fail();
+                std::memcpy(state.key.data(), body.data(), data_size);
+                state.key_id = key_id;
+                state.synced = true;
+                item.data = state.key;
+            } else {
+                if (!state.synced || key_id != state.key_id) {
+                    ++resync_count;
+                    return false;
+                }
+                auto data = state.key;
+                if (!apply_delta(body, data)) return false;
+                item.data = data;
+            }
+
+            item.head = head;
+            item.type = type;
+            item.tail = tail;
+            return true;
+        }
+
+        /// @brief 校验失败或格式错误的帧数量
+        [[nodiscard]] size_type get_error_count() const noexcept { return error_count; }
+        /// @brief 因缺少基准关键帧而丢弃的差分帧数量
+        [[nodiscard]] size_type get_resync_count() const noexcept { return resync_count; }
+    };
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "basic_bytes.hpp"
+#include "cpu_hint.hpp"
+
+namespace ly::communicating {
+    /// @brief 空闲策略，任务没有取得进展时调用 idle ，取得进展后调用 reset
+    template<typename object_type>
+    concept is_idle_policy = requires(object_type &object) {
+        { object.idle() } -> std::same_as<void>;
+        { object.reset() } -> std::same_as<void>;
+    };
+
+    /// @brief 不做任何等待，保持原有行为，由监视器或组件自行决定如何休眠
+    struct no_idle {
+        void idle() noexcept {}
+        void reset() noexcept {}
+    };
+
+    /// @brief 忙等，每次空闲执行一次 pause ，唤醒延迟最低，始终占满一个核心
+    struct spin_idle {
+        void idle() noexcept { cpu_relax(); }
+        void reset() noexcept {}
+    };
+
+    /// @brief 先忙等 spin_count 次，之后每次空闲让出时间片
+    /// @details 核心空闲时 yield 立即返回，仍然会占满核心，但有其他线程需要运行时会让出核心
+    template<size_type spin_count = 128>
+    class spin_yield_idle {
+        size_type spins{0};
+
+    public:
+        void idle() noexcept {
+            if (spins < spin_count) {
+                ++spins;
+                cpu_relax();
+            } else
+                std::this_thread::yield();
+        }
+
+        void reset() noexcept { spins = 0; }
+    };
+
+    /// @brief 指数退避，先忙等 spin_count 次，之后休眠时长从 min_sleep 开始倍增，直到 max_sleep
+    /// @details 空闲越久唤醒延迟越大，最坏情况下为 max_sleep 加上系统的定时器精度
+    template<size_type spin_count = 64>
+    class backoff_idle {
+        std::chrono::nanoseconds min_sleep;
+        std::chrono::nanoseconds max_sleep;
+        std::chrono::nanoseconds current;
+        size_type spins{0};
+
+    public:
+        backoff_idle() noexcept : backoff_idle(std::chrono::microseconds{10}, std::chrono::milliseconds{1}) {}
+
+        backoff_idle(const std::chrono::nanoseconds min_sleep, const std::chrono::nanoseconds max_sleep) noexcept :
+            min_sleep(min_sleep), max_sleep(std::max(min_sleep, max_sleep)), current(min_sleep) {}
+
+        void idle() noexcept {
+            if (spins < spin_count) {
+                ++spins;
+                cpu_relax();
+                return;
+            }
+            std::this_thread::sleep_for(current);
+            current = std::min(current * 2, max_sleep);
+        }
+
+        void reset() noexcept {
+            spins = 0;
+            current = min_sleep;
+        }
+    };
+
+    /// @brief 停车信号，生产者写入数据后调用 notify 唤醒等待中的 @c parking_idle
+    /// @details 没有线程在等待时，notify 只是一次原子自增，不会进入内核
+    class wake_signal {
+        alignas(cache_line_size) std::atomic<std::uint32_t> epoch{0};
+        alignas(cache_line_size) std::atomic<std::uint32_t> waiters{0};
+
+    public:
+        /// @brief 通知等待者，可以在任意线程调用
+        void notify() noexcept {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_seq_cst) != 0) epoch.notify_all();
+        }
+
+        [[nodiscard]] std::uint32_t current() const noexcept { return epoch.load(std::memory_order_acquire); }
+
+        /// @brief 阻塞直到 epoch 不等于 seen
+        void wait(const std::uint32_t seen) noexcept {
+            waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (epoch.load(std::memory_order_seq_cst) == seen) epoch.wait(seen, std::memory_order_acquire);
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    /// @brief 停车等待，先忙等 spin_count 次，之后通过 std::atomic::wait （Linux 上为 futex）阻塞，直到生产者调用 notify
+    /// @details 阻塞期间不占用 CPU ，唤醒延迟为一次线程调度；生产者每次写入后都必须通知，否则等待者不会醒来
+    template<size_type spin_count = 128>
+    class parking_idle {
+        std::shared_ptr<wake_signal> signal;
+        std::uint32_t seen{0};
+        size_type spins{0};
+
+    public:
+        explicit parking_idle(std::shared_ptr<wake_signal> signal) noexcept :
+            signal(std::move(signal)), seen(this->signal->current()) {}
+
+        void idle() noexcept {
+            // 上一次检查之后有新的通知，说明在本次尝试之前或期间有数据写入，立即重试
+            if (const auto current = signal->current(); current != seen) {
+                seen = current;
+                return;
+            }
+            if (spins < spin_count) {
+                ++spins;
+                cpu_relax();
+                return;
+            }
+            signal->wait(seen);
+            seen = signal->current();
+        }
+
+        void reset() noexcept {
+            spins = 0;
+            seen = signal->current();
+        }
+    };
+
+    /// @brief 投递成功后通知 @c wake_signal 的包裹接收器，用于连接生产者与使用 @c parking_idle 的任务
+    template<typename sink_type>
+        requires requires(sink_type &object, const typename sink_type::item_type &item) {
+            { object.set(item) } -> std::same_as<bool>;
+        }
+    class waking_sink {
+        std::shared_ptr<sink_type> sink;
+        std::shared_ptr<wake_signal> signal;
+
+    public:
+        using item_type = typename sink_type::item_type;
+
+        waking_sink(std::shared_ptr<sink_type> sink, std::shared_ptr<wake_signal> signal) :
+            sink(std::move(sink)), signal(std::move(signal)) {}
+
+        bool set(const item_type &item) noexcept {
+            if (!sink->set(item)) return false;
+            signal->notify();
+            return true;
+        }
+    };
+}
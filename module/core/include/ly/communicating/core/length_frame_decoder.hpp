@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+
+#include "basic_bytes.hpp"
+#include "byte_scan.hpp"
+#include "crc.hpp"
+
+namespace ly::communicating {
+    /// @brief 变长数据包的布局
+    /// @details
+    ///		数据包由定长的帧头、变长的帧体与定长的帧尾组成。帧头以 head 开头，包含长度字段与帧头校验，
+    ///		可以在帧体到达之前单独检验；帧尾为整个数据包的校验。
+    template<typename object_type>
+    concept is_frame_layout = requires(const_byte_span header, const_byte_span frame, byte_span output) {
+        { object_type::head } -> std::convertible_to<byte_type>;
+        { object_type::header_size } -> std::convertible_to<size_type>;
+        { object_type::max_frame_size } -> std::convertible_to<size_type>;
+        { object_type::verify_header(header) } -> std::same_as<bool>;
+        { object_type::frame_size(header) } -> std::same_as<size_type>;
+        { object_type::verify(frame) } -> std::same_as<bool>;
+        { object_type::payload(frame) } -> std::same_as<const_byte_span>;
+        { object_type::seal(output) } -> std::same_as<void>;
+    };
+
+    /// @brief 长度前缀的数据包布局
+    /// @details
+    ///		[head][...][length 16 位小端][...][header_check] [prefix_size 字节][payload length 字节] [body_check]
+    ///		帧头长 header_size 字节，header_check 覆盖帧头中除自身外的所有字节；
+    ///		长度字段只计算 payload ，prefix 为长度之外的固定字段（例如命令码）；body_check 覆盖帧尾之前的所有字节。
+    /// @tparam header_check 帧头校验，@c crc_algorithm 或其他提供 size 、verify 与 append 的类型
+    /// @tparam body_check 整包校验，要求同 header_check
+    template<
+        byte_type head_byte,
+        size_type header_bytes,
+        size_type length_offset,
+        typename header_check,
+        size_type prefix_size,
+        typename body_check,
+        size_type max_payload_size>
+    struct length_prefixed_layout {
+        static_assert(length_offset >= 1 && length_offset + 2 + header_check::size <= header_bytes,
+                      "length field must lie inside the header, after head and before the header check");
+
+        static constexpr byte_type head = head_byte;
+        static constexpr size_type header_size = header_bytes;
+        static constexpr size_type overhead = header_bytes + prefix_size + body_check::size;
+        static constexpr size_type max_frame_size = overhead + max_payload_size;
+
+        [[nodiscard]] static size_type payload_size(const const_byte_span header) noexcept {
+            return static_cast<size_type>(header[length_offset]) | static_cast<size_type>(header[length_offset + 1]) << 8;
+        }
+
+        [[nodiscard]] static bool verify_header(const const_byte_span header) noexcept {
+            return header_check::verify(header.first(header_size)) && payload_size(header) <= max_payload_size;
+        }
+
+        [[nodiscard]] static size_type frame_size(const const_byte_span header) noexcept {
+            return overhead + payload_size(header);
+        }
+
+        [[nodiscard]] static bool verify(const const_byte_span frame) noexcept { return body_check::verify(frame); }
+
+        /// @brief 长度之外的固定字段，例如命令码
+        [[nodiscard]] static const_byte_span prefix(const const_byte_span frame) noexcept {
+            return frame.subspan(header_size, prefix_size);
+        }
+
+        [[nodiscard]] static const_byte_span payload(const const_byte_span frame) noexcept {
+            return frame.subspan(header_size + prefix_size, frame.size() - overhead);
+        }
+
+        /// @brief 封装一个数据包，frame 的长度为 overhead 加负载长度
+        /// @details 写入头字节、长度字段与两处校验，其余帧头字段、prefix 与负载由调用者事先写好
+        static void seal(const byte_span frame) noexcept {
+            const auto length = frame.size() - overhead;
+            frame[0] = head;
+            frame[length_offset] = static_cast<byte_type>(length);
+            frame[length_offset + 1] = static_cast<byte_type>(length >> 8);
+            header_check::append(frame.first(header_size));
+            body_check::append(frame);
+        }
+    };
+
+    /// @brief 裁判系统串口协议的帧头校验，CRC-8/MAXIM 多项式，初值 0xFF
+    using referee_crc8 = crc_algorithm<8, 0x31, 0xFF, true, 0x00>;
+
+    /// @brief 裁判系统串口协议布局
+    /// @details
+    ///		SOF 0xA5 、数据长度 2 字节、包序号 1 字节、CRC8 1 字节，随后为命令码 2 字节、数据与 CRC16 2 字节，
+    ///		多字节字段均为小端。包序号与命令码通过 @c sequence 与 @c command 读取。
+    struct referee_frame_layout : length_prefixed_layout<0xA5, 5, 1, referee_crc8, 2, crc16_mcrf4xx, 1024> {
+        [[nodiscard]] static byte_type sequence(const const_byte_span frame) noexcept { return frame[3]; }
+
+        [[nodiscard]] static std::uint16_t command(const const_byte_span frame) noexcept {
+            return static_cast<std::uint16_t>(frame[5] | frame[6] << 8);
+        }
+    };
+
+    /// @brief 基于 2 的幂次环形缓冲区的变长数据包流式解码器
+    /// @details
+    ///		用法与 @c ring_frame_decoder 相同。帧头到齐后立即检验，通过后才等待帧体，
+    ///		帧头的结论在等待期间保留，帧体到达后不再重复检验帧头；检验失败时从下一个候选头字节继续，
+    ///		已经扫描过的字节不会重新扫描。输出的数据包与负载直接指向缓冲区内部，不产生拷贝。
+    /// @tparam layout 数据包布局
+    /// @tparam capacity 环形缓冲区大小，必须是 2 的幂次，且至少为两倍最大数据包大小
+    /// @note 缓冲区末尾额外保留 max_frame_size - 1 字节的镜像，因此任意位置开始的数据包在内存中都是连续的。
+    template<
+        is_frame_layout layout,
+        size_type capacity = std::max<size_type>(4096, std::bit_ceil(layout::max_frame_size * 2))>
+    class length_frame_decoder final {
+        static_assert(layout::header_size > 0 && layout::header_size <= layout::max_frame_size,
+                      "header must fit in a frame");
+        static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+        static_assert(capacity >= layout::max_frame_size * 2, "capacity must hold at least two frames");
+
+        static constexpr size_type mask = capacity - 1;
+        static constexpr size_type mirror_size = layout::max_frame_size - 1;
+
+        byte_array<capacity + mirror_size> ring{};
+
+        /// @brief 单调递增的读写计数，使用时与 mask 取模
+        size_type read_count{0};
+        size_type write_count{0};
+
+        /// @brief [read_count, scanned) 中的候选头字节位置，第 i 位对应 read_count + i ，超出 scanned 的部分尚未扫描
+        std::uint64_t candidates{0};
+        size_type scanned{0};
+
+        /// @brief 当前位置的帧头已通过检验时为整包长度，否则为 0
+        size_type pending_size{0};
+
+        [[nodiscard]] const byte_type *at(const size_type count) const noexcept {
+            return ring.data() + (count & mask);
+        }
+
+        /// @brief 将刚写入缓冲区开头的字节同步到末尾的镜像区
+        void update_mirror(const size_type begin, const size_type end) noexcept {
+            if (begin >= mirror_size) return;
+            const auto last = std::min(end, mirror_size);
+            std::memcpy(ring.data() + capacity + begin, ring.data() + begin, last - begin);
+        }
+
+        /// @brief 放弃当前位置，移动到下一个字节
+        void reject() noexcept {
+            ++read_count;
+            candidates >>= 1;
+            pending_size = 0;
+        }
+
+    public:
+        using layout_type = layout;
+
+        static constexpr auto Capacity = capacity;
+
+        /// @brief 解码得到的数据包，区间仅在回调期间有效
+        struct frame_view {
+            const_byte_span frame;
+            const_byte_span payload;
+        };
+
+        /// @brief 缓冲区中尚未被解析的字节数
+        [[nodiscard]] size_type size() const noexcept { return write_count - read_count; }
+
+        [[nodiscard]] size_type free_size() const noexcept { return capacity - size(); }
+
+        /// @brief 获取可供读取器直接写入的连续内存，写入后需要调用 @c commit
+        /// @note 返回的区间可能小于 @c free_size ，因为它不会跨过缓冲区末尾
+        [[nodiscard]] byte_span get_reader_span() noexcept {
+            const auto offset = write_count & mask;
+            return {ring.data() + offset, std::min(free_size(), capacity - offset)};
+        }
+
+        /// @brief 确认读取器已经向 @c get_reader_span 写入了 bytes 个字节
+        void commit(const size_type bytes) noexcept {
+            const auto offset = write_count & mask;
+            update_mirror(offset, offset + bytes);
+            write_count += bytes;
+        }
+
+        /// @brief 输出缓冲区中所有通过检验的数据包
+        /// @param on_frame 以 @c frame_view 为参数的回调
+        /// @return 输出的数据包数量
+        template<typename callback_type>
+        size_type extract(callback_type &&on_frame) {
+            size_type count{0};
+            while (true) {
+                if (pending_size == 0) {
+                    if (size() < layout::header_size) break;
+                    if (candidates == 0) {
+                        // 候选位置用尽，跳过已经扫描过的字节，只扫描帧头已经到齐的位置
+                        read_count = std::max(read_count, scanned);
+                        if (size() < layout::header_size) break;
+                        const auto offset = read_count & mask;
+                        const auto length = std::min({byte_scan_block, size() - layout::header_size + 1, capacity - offset});
+                        candidates = byte_mask64(ring.data() + offset, length, layout::head);
+                        scanned = read_count + length;
+                        if (candidates == 0) {
+                            read_count = scanned;
+                            continue;
+                        }
+                    }
+
+                    const auto skip = std::countr_zero(candidates);
+                    read_count += skip;
+                    candidates >>= skip;
+
+                    const const_byte_span header{at(read_count), layout::header_size};
+                    if (header.front() != layout::head || !layout::verify_header(header)) {
+                        reject();
+                        continue;
+                    }
+                    pending_size = layout::frame_size(header);
+                    if (pending_size > layout::max_frame_size || pending_size < layout::header_size) {
+                        reject();
+                        continue;
+                    }
+                }
+
+                // 帧头已通过检验，等待帧体
+                if (size() < pending_size) break;
+
+                const const_byte_span frame{at(read_count), pending_size};
+                if (!layout::verify(frame)) {
+                    reject();
+                    continue;
+                }
+                on_frame(frame_view{frame, layout::payload(frame)});
+                read_count += pending_size;
+                pending_size = 0;
+                // 同步状态下下一个数据包紧随其后，直接尝试当前位置
+                candidates = 1;
+                scanned = read_count + 1;
+                ++count;
+            }
+            return count;
+        }
+
+        /// @brief 拷贝任意长度的字节块到缓冲区，并输出其中所有通过检验的数据包
+        /// @return 输出的数据包数量
+        template<typename callback_type>
+        size_type feed(const_byte_span chunk, callback_type &&on_frame) {
+            size_type count{0};
+            while (!chunk.empty()) {
+                const auto span = get_reader_span();
+                const auto bytes = std::min(span.size(), chunk.size());
+                std::memcpy(span.data(), chunk.data(), bytes);
+                commit(bytes);
+                chunk = chunk.subspan(bytes);
+                count += extract(on_frame);
+            }
+            return count;
+        }
+
+        void clear() noexcept {
+            read_count = write_count = scanned = pending_size = 0;
+            candidates = 0;
+        }
+    };
+}
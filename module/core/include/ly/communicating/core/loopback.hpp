@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "basic_bytes.hpp"
+#include "byte_rwer.hpp"
+#include "cpu_hint.hpp"
+#include "spsc_queue.hpp"
+#include "task_metrics.hpp"
+
+namespace ly::communicating {
+    /// @brief 回环通道的损伤配置，默认值表示理想的无损通道
+    struct loopback_options {
+        /// @brief 写入被切分成长度在 [min_chunk, max_chunk] 之间的分段，每次读取最多得到一个分段；max_chunk 为 0 时每次写入为一个分段
+        size_type min_chunk{1};
+        size_type max_chunk{0};
+        /// @brief 分段从写入到可以读取的固定延迟，以及在其上均匀分布的抖动，分段之间保持顺序
+        std::chrono::nanoseconds latency{0};
+        std::chrono::nanoseconds jitter{0};
+        /// @brief 每一位被翻转的概率
+        double bit_error_rate{0};
+        /// @brief 每个分段被整体丢弃的概率，模拟接收溢出
+        double drop_rate{0};
+        /// @brief 随机数种子，相同的种子与相同的写入序列得到相同的分段、损坏与丢弃
+        std::uint64_t seed{1};
+    };
+
+    /// @brief 回环通道的统计，由写入方记录
+    struct loopback_stats {
+        std::uint64_t sent_bytes{0};
+        std::uint64_t dropped_bytes{0};
+        std::uint64_t dropped_chunks{0};
+        std::uint64_t flipped_bits{0};
+    };
+
+    namespace details {
+        /// @brief splitmix64 伪随机数，状态只有 8 字节，速度远快于 std::mt19937_64
+        class split_mix64 {
+            std::uint64_t state;
+
+        public:
+            explicit split_mix64(const std::uint64_t seed) noexcept : state(seed) {}
+
+            std::uint64_t next() noexcept {
+                auto value = state += 0x9E3779B97F4A7C15;
+                value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+                value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+                return value ^ (value >> 31);
+            }
+
+            /// @brief [0, 1) 上的均匀分布
+            double uniform() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+            /// @brief [low, high] 上的均匀整数
+            size_type between(const size_type low, const size_type high) noexcept {
+                return low + static_cast<size_type>(next() % (high - low + 1));
+            }
+        };
+    }
+
+    /// @brief 单向回环通道，一个线程写入、一个线程读取，数据经过无锁字节环
+    /// @details
+    ///		写入方按配置切分分段、注入丢弃与位翻转，并为每个分段计算可读时刻；分段描述通过 @c spsc_queue 传递。
+    ///		位翻转按几何分布抽取下一个翻转位置，开销与翻转次数成正比，与字节数无关；
+    ///		没有延迟与抖动时不读取时钟。读写都不阻塞，环满时写入返回已接受的字节数，没有可读分段时读取返回 0 。
+    ///		分段只在完整放得下时写入，同一种子与同样的写入序列得到同样的分段、丢弃与翻转，与读取方的快慢无关。
+    /// @tparam capacity 字节环大小，必须是 2 的幂次
+    /// @tparam max_segments 在途分段的最大数量，必须是 2 的幂次
+    template<size_type capacity = 65536, size_type max_segments = 4096>
+    class loopback_channel final {
+        static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+
+        static constexpr size_type mask = capacity - 1;
+
+        struct segment {
+            size_type size{0};
+            /// @brief 可以读取的时刻，steady_clock 纳秒，0 表示立即可读
+            std::int64_t release_ns{0};
+        };
+
+        /// @brief 读取方已经读完的字节数，写入方据此计算剩余空间
+        alignas(cache_line_size) std::atomic<size_type> read_count{0};
+        segment current{};
+        size_type current_left{0};
+
+        alignas(cache_line_size) size_type write_count{0};
+        size_type cached_read_count{0};
+        loopback_options options;
+        details::split_mix64 random;
+        /// @brief 距离下一次位翻转还有多少位
+        std::uint64_t flip_countdown{0};
+        std::int64_t last_release_ns{0};
+        /// @brief 当前分段还没有写入的字节数，环或分段队列满时留到下一次 send ，使随机序列与读取方的快慢无关
+        size_type pending_size{0};
+        bool pending_drop{false};
+        std::int64_t pending_jitter{0};
+        std::atomic<std::uint64_t> sent_bytes{0};
+        std::atomic<std::uint64_t> dropped_bytes{0};
+        std::atomic<std::uint64_t> dropped_chunks{0};
+        std::atomic<std::uint64_t> flipped_bits{0};
+
+        spsc_queue<segment, max_segments> segments;
+
+        alignas(cache_line_size) byte_array<capacity> ring{};
+
+        [[nodiscard]] static std::int64_t now_ns() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        [[nodiscard]] std::uint64_t next_flip_distance() noexcept {
+            if (options.bit_error_rate >= 1) return 0;
+            const auto distance = std::log1p(-random.uniform()) / std::log1p(-options.bit_error_rate);
+            return distance >= 1e18 ? std::uint64_t{1} << 60 : static_cast<std::uint64_t>(distance);
+        }
+
+        /// @brief 翻转环中 [begin, begin + size) 范围内按几何分布抽中的位
+        void flip_bits(const size_type begin, const size_type size) noexcept {
+            auto remaining = static_cast<std::uint64_t>(size) * 8;
+            std::uint64_t position{0};
+            std::uint64_t flips{0};
+            while (flip_countdown < remaining) {
+                position += flip_countdown;
+                ring[(begin + position / 8) & mask] ^= static_cast<byte_type>(1u << (position % 8));
+                ++flips;
+                remaining -= flip_countdown + 1;
+                ++position;
+                flip_countdown = next_flip_distance();
+            }
+            flip_countdown -= remaining;
+            if (flips != 0) details::single_writer_add(flipped_bits, flips);
+        }
+
+        void copy_in(const const_byte_span data) noexcept {
+            const auto offset = write_count & mask;
+            const auto first = std::min(data.size(), capacity - offset);
+            std::memcpy(ring.data() + offset, data.data(), first);
+            std::memcpy(ring.data(), data.data() + first, data.size() - first);
+        }
+
+        void copy_out(const byte_span data, const size_type from) const noexcept {
+            const auto offset = from & mask;
+            const auto first = std::min(data.size(), capacity - offset);
+            std::memcpy(data.data(), ring.data() + offset, first);
+            std::memcpy(data.data() + first, ring.data(), data.size() - first);
+        }
+
+    public:
+        static constexpr auto Capacity = capacity;
+
+        explicit loopback_channel(const loopback_options &options = {}) noexcept :
+            options(options), random(options.seed) {
+            this->options.min_chunk = std::max<size_type>(1, options.min_chunk);
+            this->options.max_chunk = options.max_chunk == 0 ? 0 : std::max(this->options.min_chunk, options.max_chunk);
+            if (options.bit_error_rate > 0) flip_countdown = next_flip_distance();
+        }
+
+        loopback_channel(const loopback_channel &) = delete;
+        loopback_channel &operator=(const loopback_channel &) = delete;
+
+        /// @brief 写入方调用
+        /// @return 接受的字节数，包括被丢弃的分段；环或分段队列放不下下一个分段时小于 data.size()
+        size_type send(const const_byte_span data) noexcept {
+            const bool timed = options.latency.count() != 0 || options.jitter.count() != 0;
+            const auto now = timed ? now_ns() : 0;
+            size_type sent{0};
+            while (sent < data.size()) {
+                if (pending_size == 0) {
+                    // 配置了分段大小时分段按字节流切分，可以跨越多次 send ，否则每次 send 的数据为一个分段
+                    const auto size = options.max_chunk != 0 ? random.between(options.min_chunk, options.max_chunk)
+                                                             : data.size() - sent;
+                    pending_size = std::min(size, capacity);
+                    pending_drop = options.drop_rate > 0 && random.uniform() < options.drop_rate;
+                    if (pending_drop) details::single_writer_add(dropped_chunks, 1);
+                    pending_jitter = 0;
+                    if (timed && options.jitter.count() > 0)
+                        pending_jitter = static_cast<std::int64_t>(random.uniform() * static_cast<double>(options.jitter.count()));
+                }
+                const auto size = std::min(pending_size, data.size() - sent);
+
+                if (pending_drop) {
+                    details::single_writer_add(dropped_bytes, size);
+                    sent += size;
+                    pending_size -= size;
+                    continue;
+                }
+
+                // 先确认环与分段队列都放得下整个分段，再写入字节与翻转位，满时不消耗任何随机数
+                if (capacity - (write_count - cached_read_count) < size)
+                    cached_read_count = read_count.load(std::memory_order_acquire);
+                if (capacity - (write_count - cached_read_count) < size || segments.size() >= max_segments) break;
+
+                segment piece{size, 0};
+                if (timed) {
+                    piece.release_ns = std::max(last_release_ns, now + options.latency.count() + pending_jitter);
+                    last_release_ns = piece.release_ns;
+                }
+
+                copy_in(data.subspan(sent, size));
+                if (options.bit_error_rate > 0) flip_bits(write_count, size);
+                // 分段描述通过队列以 release 语义发布，读取方取得描述时字节已经可见
+                segments.push(piece);
+                write_count += size;
+                sent += size;
+                pending_size -= size;
+            }
+            details::single_writer_add(sent_bytes, sent);
+            return sent;
+        }
+
+        /// @brief 读取方调用，每次最多读取一个分段中尚未读取的部分
+        /// @return 读取的字节数，没有到达可读时刻的分段时为 0
+        size_type receive(const byte_span buffer) noexcept {
+            if (current_left == 0) {
+                if (!segments.pop(current)) return 0;
+                current_left = current.size;
+            }
+            if (current.release_ns != 0 && now_ns() < current.release_ns) return 0;
+
+            const auto from = read_count.load(std::memory_order_relaxed);
+            const auto bytes = std::min(buffer.size(), current_left);
+            copy_out(buffer.first(bytes), from);
+            current_left -= bytes;
+            read_count.store(from + bytes, std::memory_order_release);
+            return bytes;
+        }
+
+        /// @brief 统计快照，可以在任意线程调用
+        [[nodiscard]] loopback_stats get_stats() const noexcept {
+            return {
+                sent_bytes.load(std::memory_order_relaxed),
+                dropped_bytes.load(std::memory_order_relaxed),
+                dropped_chunks.load(std::memory_order_relaxed),
+                flipped_bits.load(std::memory_order_relaxed)
+            };
+        }
+    };
+
+    /// @brief 回环读写器，写入发送通道，从接收通道读取
+    template<size_type capacity = 65536>
+    class loopback_rwer final : public byte_rwer {
+    public:
+        using channel_type = loopback_channel<capacity>;
+
+    private:
+        std::shared_ptr<channel_type> tx;
+        std::shared_ptr<channel_type> rx;
+
+    public:
+        loopback_rwer(std::shared_ptr<channel_type> tx, std::shared_ptr<channel_type> rx) :
+            tx(std::move(tx)), rx(std::move(rx)) {}
+
+        [[nodiscard]] size_type read(const byte_span buffer) override { return rx->receive(buffer); }
+
+        [[nodiscard]] size_type write(const const_byte_span buffer) override { return tx->send(buffer); }
+
+        [[nodiscard]] const channel_type &get_tx() const noexcept { return *tx; }
+        [[nodiscard]] const channel_type &get_rx() const noexcept { return *rx; }
+    };
+
+    /// @brief 创建一对相连的回环读写器，first 写入的数据由 second 读取，反之亦然
+    /// @param first_to_second first 到 second 方向的损伤配置
+    /// @param second_to_first second 到 first 方向的损伤配置
+    template<size_type capacity = 65536>
+    [[nodiscard]] std::pair<std::shared_ptr<loopback_rwer<capacity>>, std::shared_ptr<loopback_rwer<capacity>>>
+    make_loopback_pair(const loopback_options &first_to_second = {}, const loopback_options &second_to_first = {}) {
+        using channel_type = loopback_channel<capacity>;
+        auto forward = std::make_shared<channel_type>(first_to_second);
+        auto backward = std::make_shared<channel_type>(second_to_first);
+        return {
+            std::make_shared<loopback_rwer<capacity>>(forward, backward),
+            std::make_shared<loopback_rwer<capacity>>(backward, forward)
+        };
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "basic_bytes.hpp"
+#include "basic_tasks.hpp"
+#include "typed_message.hpp"
+
+namespace ly::communicating {
+    /// @brief 消息类型到数据结构与投递位置的绑定
+    /// @tparam type_id 消息的 type 字节
+    /// @tparam TPayload 数据区对应的结构体，必须可平凡拷贝
+    /// @tparam TSink 接收 TPayload 的投递位置
+    template<byte_type type_id, typename TPayload, typename TSink>
+        requires std::is_trivially_copyable_v<TPayload> && std::default_initializable<TPayload>
+                 && is_item_sink<TSink, TPayload>
+    struct message_route {
+        static constexpr byte_type type = type_id;
+        using payload_type = TPayload;
+        using sink_type = TSink;
+    };
+
+    /// @brief 根据 @c typed_message 的 type 字节，将数据区投递到对应位置的路由器
+    /// @details
+    ///		分发表在编译期生成，共 256 项，每项是一个函数指针与该类型数据结构的大小，
+    ///		分发时只需要一次查表与一次间接调用，没有虚函数。
+    ///		路由器本身满足 @c is_item_sink ，可以直接作为 @c reader_task 的投递位置。
+    /// @tparam data_size 消息数据区大小，每种数据结构都不能超过此大小
+    template<size_type data_size, typename... TRoutes>
+    class message_router final {
+        static_assert(sizeof...(TRoutes) > 0, "at least one route is required");
+        static_assert(((sizeof(typename TRoutes::payload_type) <= data_size) && ...),
+            "payload is larger than the message data");
+
+        static constexpr bool has_unique_types() noexcept {
+            constexpr std::array types{TRoutes::type...};
+            for (size_type i = 0; i < types.size(); ++i)
+                for (size_type j = i + 1; j < types.size(); ++j)
+                    if (types[i] == types[j]) return false;
+            return true;
+        }
+
+        static_assert(has_unique_types(), "duplicated message type");
+
+        using route_tuple = std::tuple<TRoutes...>;
+        using handler_type = bool(*)(message_router &, const byte_type *) noexcept;
+
+        struct dispatch_entry {
+            handler_type handler{nullptr};
+            size_type size{0};
+        };
+
+        using dispatch_table = std::array<dispatch_entry, std::numeric_limits<byte_type>::max() + 1>;
+
+        std::tuple<std::shared_ptr<typename TRoutes::sink_type>...> sinks;
+
+        template<size_type index>
+        static bool deliver(message_router &router, const byte_type *data) noexcept {
+            using payload_type = typename std::tuple_element_t<index, route_tuple>::payload_type;
+            payload_type payload;
+            std::memcpy(&payload, data, sizeof(payload_type));
+            return std::get<index>(router.sinks)->set(payload);
+        }
+
+        static constexpr dispatch_table make_table() noexcept {
+            dispatch_table table{};
+            [&table]<size_type... index>(std::index_sequence<index...>) {
+                ((table[std::tuple_element_t<index, route_tuple>::type] = {
+                    &deliver<index>,
+                    sizeof(typename std::tuple_element_t<index, route_tuple>::payload_type)
+                }), ...);
+            }(std::index_sequence_for<TRoutes...>{});
+            return table;
+        }
+
+        static constexpr dispatch_table table = make_table();
+
+    public:
+        using item_type = typed_message<data_size>;
+
+        explicit message_router(std::shared_ptr<typename TRoutes::sink_type>... sinks) :
+            sinks(std::move(sinks)...) {}
+
+        /// @brief 判断给定类型是否有对应的路由
+        [[nodiscard]] static constexpr bool is_routed(const byte_type type) noexcept {
+            return table[type].handler != nullptr;
+        }
+
+        /// @brief 将数据区投递到 type 对应的位置
+        /// @param data 数据区，大小不能小于该类型数据结构的大小
+        /// @return 没有对应路由、数据区大小不足或投递失败时返回 false
+        [[nodiscard]] bool dispatch(const byte_type type, const const_byte_span data) noexcept {
+            const auto &entry = table[type];
+            if (entry.handler == nullptr || data.size() < entry.size) return false;
+            return entry.handler(*this, data.data());
+        }
+
+        /// @brief 直接从解码缓冲区中的完整消息投递，布局与 @c item_type 一致
+        [[nodiscard]] bool route(const const_byte_span frame) noexcept {
+            if (frame.size() != sizeof(item_type)) return false;
+            return dispatch(frame[offsetof(item_type, type)],
+                frame.subspan(offsetof(item_type, data), data_size));
+        }
+
+        bool set(const item_type &message) noexcept {
+            return dispatch(message.type, message.data);
+        }
+    };
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "basic_bytes.hpp"
+
+namespace ly::communicating {
+    namespace details {
+        template<typename>
+        struct member_pointer_traits;
+
+        template<typename TClass, typename TMember>
+        struct member_pointer_traits<TMember TClass::*> {
+            using class_type = TClass;
+            using member_type = TMember;
+        };
+
+        /// @brief 与 value_type 等宽的无符号整数，用于在线路格式与内存之间搬运位模式
+        template<typename value_type>
+        struct wire_storage {
+            using type = std::make_unsigned_t<value_type>;
+        };
+
+        template<>
+        struct wire_storage<bool> {
+            using type = std::uint8_t;
+        };
+
+        template<typename value_type>
+            requires std::is_enum_v<value_type>
+        struct wire_storage<value_type> : wire_storage<std::underlying_type_t<value_type>> {};
+
+        template<std::floating_point value_type>
+        struct wire_storage<value_type> {
+            using type = std::conditional_t<sizeof(value_type) == 4, std::uint32_t, std::uint64_t>;
+        };
+    }
+
+    /// @brief 线路格式中的一个字段，绑定到内存结构体的一个成员
+    /// @details
+    ///		bit_width 为 0 时字段与成员等宽，占 sizeof 成员 个字节；否则为位域，
+    ///		从 byte_offset 开始、按 order 字节序读出覆盖该位域的最少字节，组成整数后取第 bit_offset 位起的 bit_width 位，
+    ///		有符号成员会做符号扩展。浮点数只能整宽传输。
+    /// @tparam member 成员指针，例如 &imu::yaw
+    /// @tparam byte_offset 字段在线路格式中的起始字节
+    template<auto member, size_type byte_offset, std::endian order = std::endian::little,
+        size_type bit_width = 0, size_type bit_offset = 0>
+        requires std::is_member_object_pointer_v<decltype(member)>
+    struct wire_field {
+        using class_type = typename details::member_pointer_traits<decltype(member)>::class_type;
+        using value_type = typename details::member_pointer_traits<decltype(member)>::member_type;
+        using storage_type = typename details::wire_storage<value_type>::type;
+
+        static constexpr bool is_bit_field = bit_width != 0;
+        static constexpr size_type bits = is_bit_field ? bit_width : sizeof(value_type) * 8;
+        static constexpr size_type bytes = (bit_offset + bits + 7) / 8;
+        static constexpr size_type first_byte = byte_offset;
+        static constexpr size_type end_byte = byte_offset + bytes;
+
+        static_assert(std::is_integral_v<value_type> || std::is_enum_v<value_type> || std::is_floating_point_v<value_type>,
+                      "wire fields must be integers, enums or floating point numbers");
+        static_assert(!is_bit_field || !std::is_floating_point_v<value_type>, "floating point fields must be full width");
+        static_assert(bits <= sizeof(value_type) * 8, "bit width exceeds the member");
+        static_assert(is_bit_field ? bit_offset < 8 : bit_offset == 0, "bit offset must be within the first byte");
+        static_assert(bytes <= 8, "a wire field may span at most 8 bytes");
+
+    private:
+        static constexpr std::uint64_t mask = bits == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+
+    public:
+        /// @brief 字段在第 byte_offset + i 个字节中占用的位
+        /// @details 位域的位号是在按 order 组成的整数中计算的，大端序多字节位域的低位落在最后一个字节，因此逐字节映射回线路格式
+        static constexpr std::array<byte_type, bytes> occupancy = [] {
+            std::array<byte_type, bytes> result{};
+            const auto used = mask << bit_offset;
+            for (size_type i = 0; i < bytes; ++i) {
+                const auto index = order == std::endian::little ? i : bytes - 1 - i;
+                result[index] = static_cast<byte_type>(used >> (i * 8));
+            }
+            return result;
+        }();
+
+    private:
+
+        /// @brief 宽度为 1 、2 、4 、8 字节且与主机字节序相同时，运行时直接整字读写
+        static constexpr bool is_native_word = order == std::endian::native && std::has_single_bit(bytes);
+
+        using word_type = std::conditional_t<bytes == 1, std::uint8_t, std::conditional_t<bytes == 2, std::uint16_t,
+            std::conditional_t<bytes <= 4, std::uint32_t, std::uint64_t>>>;
+
+        [[nodiscard]] static constexpr std::uint64_t load(const const_byte_span wire) noexcept {
+            if constexpr (is_native_word) {
+                if (!std::is_constant_evaluated()) {
+                    word_type word;
+                    std::memcpy(&word, wire.data() + byte_offset, bytes);
+                    return word;
+                }
+            }
+            std::uint64_t raw{0};
+            for (size_type i = 0; i < bytes; ++i) {
+                if constexpr (order == std::endian::little)
+                    raw |= std::uint64_t{wire[byte_offset + i]} << (i * 8);
+                else
+                    raw = raw << 8 | wire[byte_offset + i];
+            }
+            return raw;
+        }
+
+        static constexpr void store(const byte_span wire, std::uint64_t raw) noexcept {
+            if constexpr (is_native_word) {
+                if (!std::is_constant_evaluated()) {
+                    const auto word = static_cast<word_type>(raw);
+                    std::memcpy(wire.data() + byte_offset, &word, bytes);
+                    return;
+                }
+            }
+            for (size_type i = 0; i < bytes; ++i) {
+                if constexpr (order == std::endian::little)
+                    wire[byte_offset + i] = static_cast<byte_type>(raw >> (i * 8));
+                else
+                    wire[byte_offset + bytes - 1 - i] = static_cast<byte_type>(raw >> (i * 8));
+            }
+        }
+
+    public:
+        /// @brief 从线路格式读出字段，写入 item 的成员
+        static constexpr void read(const const_byte_span wire, class_type &item) noexcept {
+            auto raw = load(wire);
+            if constexpr (is_bit_field) {
+                raw = raw >> bit_offset & mask;
+                if constexpr (std::is_signed_v<value_type>)
+                    if (raw >> (bits - 1) & 1) raw |= ~mask;
+            }
+            const auto storage = static_cast<storage_type>(raw);
+            if constexpr (std::is_same_v<value_type, bool>)
+                item.*member = storage != 0;
+            else if constexpr (std::is_floating_point_v<value_type> || std::is_enum_v<value_type>)
+                item.*member = std::bit_cast<value_type>(storage);
+            else
+                item.*member = static_cast<value_type>(storage);
+        }
+
+        /// @brief 将 item 的成员写入线路格式，位域只修改自身所占的位
+        static constexpr void write(const class_type &item, const byte_span wire) noexcept {
+            std::uint64_t raw;
+            if constexpr (std::is_same_v<value_type, bool>)
+                raw = item.*member ? 1 : 0;
+            else if constexpr (std::is_floating_point_v<value_type> || std::is_enum_v<value_type>)
+                raw = std::bit_cast<storage_type>(item.*member);
+            else
+                raw = static_cast<storage_type>(item.*member);
+            if constexpr (is_bit_field)
+                raw = (load(wire) & ~(mask << bit_offset)) | (raw & mask) << bit_offset;
+            store(wire, raw);
+        }
+    };
+
+    /// @brief 编译期消息描述，在紧凑的线路格式与自然对齐的内存结构体之间转换
+    /// @details
+    ///		每个字段的偏移、宽度与字节序都在编译期确定，与主机字节序相同的整字字段直接整字读写，其余逐字节移位，
+    ///		展开后为直线代码，不依赖 reinterpret_cast 、#pragma pack 或主机字节序，也可以在常量表达式中使用。
+    ///		线路格式中没有被任何字段覆盖的位，写入时保持原值。
+    /// @tparam TItem 内存中的结构体
+    /// @tparam TFields @c wire_field 列表，不能相互重叠
+    template<typename TItem, typename... TFields>
+        requires std::default_initializable<TItem> && (std::is_base_of_v<typename TFields::class_type, TItem> && ...)
+    struct message_schema {
+        static_assert(sizeof...(TFields) > 0, "at least one field is required");
+
+        using item_type = TItem;
+
+        /// @brief 线路格式的字节数，等于最后一个字段的结束位置
+        static constexpr size_type wire_size = std::max({TFields::end_byte...});
+
+    private:
+        /// @brief 按字节累计各字段占用的位，任意两个字段在同一字节中占用同一位即为重叠
+        static constexpr bool has_no_overlap() noexcept {
+            std::array<byte_type, wire_size> used{};
+            bool overlapped{false};
+            const auto mark = [&]<typename field>() {
+                for (size_type i = 0; i < field::bytes; ++i) {
+                    auto &byte = used[field::first_byte + i];
+                    if (byte & field::occupancy[i]) overlapped = true;
+                    byte = static_cast<byte_type>(byte | field::occupancy[i]);
+                }
+            };
+            (mark.template operator()<TFields>(), ...);
+            return !overlapped;
+        }
+
+        static_assert(has_no_overlap(), "wire fields overlap");
+
+    public:
+        /// @brief 从线路格式读出所有字段，wire 至少为 wire_size 字节
+        static constexpr void read(const const_byte_span wire, item_type &item) noexcept {
+            (TFields::read(wire, item), ...);
+        }
+
+        /// @brief 将所有字段写入线路格式，wire 至少为 wire_size 字节
+        static constexpr void write(const item_type &item, const byte_span wire) noexcept {
+            (TFields::write(item, wire), ...);
+        }
+
+        [[nodiscard]] static constexpr item_type decode(const const_byte_span wire) noexcept {
+            item_type item{};
+            read(wire, item);
+            return item;
+        }
+
+        [[nodiscard]] static constexpr std::array<byte_type, wire_size> encode(const item_type &item) noexcept {
+            std::array<byte_type, wire_size> wire{};
+            write(item, wire);
+            return wire;
+        }
+
+        /// @brief 满足 @c is_byte_packer 的包装器，缓冲区不足 wire_size 字节时失败
+        struct packer {
+            using item_type = TItem;
+
+            bool pack(const const_byte_span buffer, item_type &item) const noexcept {
+                if (buffer.size() < wire_size) return false;
+                read(buffer, item);
+                return true;
+            }
+        };
+
+        /// @brief 满足 @c is_item_unpacker 的拆包器，缓冲区不足 wire_size 字节时失败
+        struct unpacker {
+            using item_type = TItem;
+
+            bool unpack(const item_type &item, const byte_span buffer) const noexcept {
+                if (buffer.size() < wire_size) return false;
+                write(item, buffer);
+                return true;
+            }
+        };
+    };
+}
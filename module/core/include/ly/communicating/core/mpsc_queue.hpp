@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <type_traits>
+
+#include "basic_bytes.hpp"
+#include "cpu_hint.hpp"
+
+namespace ly::communicating {
+    /// @brief 有界无锁多写单读队列，多个线程共享一个 @c writer_task 时作为它的来源
+    /// @details
+    ///		每个槽位带有一个序号，写入者通过一次 CAS 抢占写入位置，写完后更新槽位序号发布数据；
+    ///		读取者按位置顺序读取，只有自己推进读取位置，不需要 CAS。
+    ///		同一个写入者的数据按写入顺序被读出，不同写入者之间按抢占位置的先后排序。
+    /// @note
+    ///		某个写入者抢占位置后被挂起时，读取者会在该位置等待，之后的数据暂时不可读，但不会丢失。
+    /// @tparam capacity 队列容量，必须是 2 的幂次
+    template<typename TItem, size_type capacity>
+        requires std::default_initializable<TItem> && std::is_copy_assignable_v<TItem>
+    class mpsc_queue final {
+        static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+
+    public:
+        using item_type = TItem;
+        static constexpr auto Capacity = capacity;
+
+    private:
+        static constexpr size_type mask = capacity - 1;
+
+        struct cell {
+            std::atomic<size_type> sequence;
+            item_type item{};
+        };
+
+        /// @brief 写入者共享的写入位置
+        alignas(cache_line_size) std::atomic<size_type> enqueue_position{0};
+        std::atomic<size_type> contended{0};
+
+        /// @brief 读取者独占的读取位置
+        alignas(cache_line_size) size_type dequeue_position{0};
+
+        alignas(cache_line_size) std::array<cell, capacity> cells;
+
+    public:
+        mpsc_queue() noexcept {
+            for (size_type i = 0; i < capacity; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_queue(const mpsc_queue &) = delete;
+        mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+        /// @brief 写入一个数据，可以被任意线程同时调用，队列已满时返回 false
+        bool push(const item_type &item) noexcept {
+            auto position = enqueue_position.load(std::memory_order_relaxed);
+            cell *target;
+            while (true) {
+                target = &cells[position & mask];
+                const auto sequence = target->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::make_signed_t<size_type>>(sequence - position);
+                if (difference == 0) {
+                    if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                    contended.fetch_add(1, std::memory_order_relaxed);
+                } else if (difference < 0)
+                    return false;
+                else
+                    position = enqueue_position.load(std::memory_order_relaxed);
+            }
+            target->item = item;
+            target->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief 读取一个数据，只能由一个线程调用，没有可读数据时返回 false
+        bool pop(item_type &item) noexcept {
+            auto &target = cells[dequeue_position & mask];
+            if (target.sequence.load(std::memory_order_acquire) != dequeue_position + 1) return false;
+            item = target.item;
+            target.sequence.store(dequeue_position + capacity, std::memory_order_release);
+            ++dequeue_position;
+            return true;
+        }
+
+        /// @brief 与 @c is_item_sink 兼容的写入接口
+        bool set(const item_type &item) noexcept { return push(item); }
+
+        /// @brief 与 @c is_item_source 兼容的读取接口
+        bool get(item_type &item) noexcept { return pop(item); }
+
+        /// @brief 写入者抢占位置失败重试的总次数，用于观察竞争程度
+        [[nodiscard]] size_type contention_count() const noexcept {
+            return contended.load(std::memory_order_relaxed);
+        }
+    };
+}
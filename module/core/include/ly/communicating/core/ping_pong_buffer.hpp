@@ -5,14 +5,15 @@
 #include <algorithm>
 
 #include "basic_bytes.hpp"
+#include "byte_scan.hpp"
 
 namespace ly::communicating {
     using byte_verifier = bool(*)(const_byte_span);
 
     [[nodiscard]] inline bool find_head_byte(const_byte_span &span, byte_type head) noexcept {
-        const auto head_index = std::ranges::find(span, head);
-        if (head_index == span.end()) return false;
-        span = span.subspan(head_index - span.begin());
+        const auto head_index = find_byte(span, head);
+        if (head_index == span.size()) return false;
+        span = span.subspan(head_index);
         return true;
     }
 
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "basic_bytes.hpp"
+#include "byte_scan.hpp"
+#include "ping_pong_buffer.hpp"
+
+namespace ly::communicating {
+    /// @brief 基于 2 的幂次环形缓冲区的定长数据包流式解码器。
+    ///		读取器可以一次写入任意长度的字节，随后 @c extract 在一次遍历中输出缓冲区内所有通过检验的数据包。
+    ///		校验失败或者未对齐时，从下一个头字节处重新同步。
+    /// @tparam frame_size 数据包大小
+    /// @tparam verify 用于检验数据包是否符合要求
+    /// @tparam capacity 环形缓冲区大小，必须是 2 的幂次，且至少为两倍数据包大小
+    /// @note
+    ///		缓冲区末尾额外保留 frame_size - 1 字节，作为开头字节的镜像，
+    ///		因此任意位置开始的数据包在内存中都是连续的，检验与输出时不需要拷贝。
+    template<
+        size_type frame_size,
+        byte_verifier verify,
+        size_type capacity = std::max<size_type>(4096, std::bit_ceil(frame_size * 2))>
+    class ring_frame_decoder final {
+        static_assert(frame_size > 0, "frame_size must be positive");
+        static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+        static_assert(capacity >= frame_size * 2, "capacity must hold at least two frames");
+
+        static constexpr size_type mask = capacity - 1;
+        static constexpr size_type mirror_size = frame_size - 1;
+
+        byte_array<capacity + mirror_size> ring{};
+
+        /// @brief 单调递增的读写计数，使用时与 mask 取模
+        size_type read_count{0};
+        size_type write_count{0};
+
+        [[nodiscard]] const byte_type *at(const size_type count) const noexcept {
+            return ring.data() + (count & mask);
+        }
+
+        /// @brief 将刚写入缓冲区开头的字节同步到末尾的镜像区
+        void update_mirror(const size_type begin, const size_type end) noexcept {
+            if (begin >= mirror_size) return;
+            const auto last = std::min(end, mirror_size);
+            std::memcpy(ring.data() + capacity + begin, ring.data() + begin, last - begin);
+        }
+
+    public:
+        static constexpr auto FrameSize = frame_size;
+        static constexpr auto Capacity = capacity;
+
+        byte_type head{'!'};
+
+        ring_frame_decoder() = default;
+
+        explicit ring_frame_decoder(const byte_type head) noexcept : head(head) {}
+
+        /// @brief 缓冲区中尚未被解析的字节数
+        [[nodiscard]] size_type size() const noexcept { return write_count - read_count; }
+
+        [[nodiscard]] size_type free_size() const noexcept { return capacity - size(); }
+
+        /// @brief 获取可供读取器直接写入的连续内存，写入后需要调用 @c commit
+        /// @note 返回的区间可能小于 @c free_size ，因为它不会跨过缓冲区末尾
+        [[nodiscard]] byte_span get_reader_span() noexcept {
+            const auto offset = write_count & mask;
+            return {ring.data() + offset, std::min(free_size(), capacity - offset)};
+        }
+
+        /// @brief 确认读取器已经向 @c get_reader_span 写入了 bytes 个字节
+        void commit(const size_type bytes) noexcept {
+            const auto offset = write_count & mask;
+            update_mirror(offset, offset + bytes);
+            write_count += bytes;
+        }
+
+        /// @brief 输出缓冲区中所有通过检验的数据包
+        /// @param on_frame 以 const_byte_span 为参数的回调，区间直接指向缓冲区内部，仅在回调期间有效
+        /// @return 输出的数据包数量
+        template<typename callback_type>
+        size_type extract(callback_type &&on_frame) {
+            size_type count{0};
+            // 尚未尝试的候选头字节位置，第 i 位对应 read_count + i。
+            // 同步状态下只尝试当前位置，失步后一次扫描最多 64 个位置，逐个尝试而不重复扫描
+            std::uint64_t candidates{1};
+            while (size() >= frame_size) {
+                if (candidates == 0) {
+                    const auto offset = read_count & mask;
+                    const auto length = std::min({byte_scan_block, size() - frame_size + 1, capacity - offset});
+                    candidates = byte_mask64(ring.data() + offset, length, head);
+                    if (candidates == 0) {
+                        read_count += length;
+                        continue;
+                    }
+                }
+
+                const auto skip = std::countr_zero(candidates);
+                read_count += skip;
+                candidates >>= skip;
+
+                const const_byte_span frame{at(read_count), frame_size};
+                if (frame.front() == head && verify(frame)) {
+                    on_frame(frame);
+                    read_count += frame_size;
+                    ++count;
+                    candidates = 1;
+                    continue;
+                }
+                ++read_count;
+                candidates >>= 1;
+            }
+            return count;
+        }
+
+        /// @brief 拷贝任意长度的字节块到缓冲区，并输出其中所有通过检验的数据包
+        /// @return 输出的数据包数量
+        template<typename callback_type>
+        size_type feed(const_byte_span chunk, callback_type &&on_frame) {
+            size_type count{0};
+            while (!chunk.empty()) {
+                const auto span = get_reader_span();
+                const auto bytes = std::min(span.size(), chunk.size());
+                std::memcpy(span.data(), chunk.data(), bytes);
+                commit(bytes);
+                chunk = chunk.subspan(bytes);
+                count += extract(on_frame);
+            }
+            return count;
+        }
+
+        void clear() noexcept { read_count = write_count = 0; }
+    };
+
+    /// @brief 可替代 @c reader_toolkit 的流式读取工具，一次读取可以输出多个数据包
+    /// @details
+    ///		读取器写入 @c reader_span() ，随后调用 @c examine(bytes, on_message) ，
+    ///		每个通过检验的数据包都会被拷贝到 @c result() 中，然后调用一次 on_message
+    template<typename TMessage, byte_verifier verify,
+        size_type capacity = std::max<size_type>(4096, std::bit_ceil(sizeof(TMessage) * 2))>
+    struct ring_reader_toolkit final {
+        using msg_type = TMessage;
+
+        ring_frame_decoder<sizeof(TMessage), verify, capacity> decoder{};
+
+        byte_array<sizeof(TMessage)> result_buffer{};
+
+        ring_reader_toolkit() = default;
+
+        explicit ring_reader_toolkit(const byte_type head) noexcept : decoder(head) {}
+
+        [[nodiscard]] byte_span reader_span() noexcept { return decoder.get_reader_span(); }
+
+        /// @brief 确认读取器写入了 bytes 个字节，并输出所有完整的数据包
+        /// @return 输出的数据包数量
+        template<typename callback_type>
+        size_type examine(const size_type bytes, callback_type &&on_message) {
+            decoder.commit(bytes);
+            return decoder.extract([this, &on_message](const const_byte_span frame) {
+                std::ranges::copy(frame, result_buffer.begin());
+                on_message(result());
+            });
+        }
+
+        TMessage &result() noexcept { return *reinterpret_cast<msg_type *>(result_buffer.data()); }
+
+        const TMessage &result() const noexcept { return *reinterpret_cast<const msg_type *>(result_buffer.data()); }
+
+        byte_span result_span() noexcept { return result_buffer; }
+
+        const_byte_span result_span() const noexcept { return result_buffer; }
+    };
+}
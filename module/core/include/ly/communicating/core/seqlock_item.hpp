@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "basic_bytes.hpp"
+#include "cpu_hint.hpp"
+
+namespace ly::communicating {
+    /// @brief 基于顺序锁的单写多读最新值存储，可以替代 @c shared_atomic_optional_item
+    /// @details
+    ///		写入者先将序号加一（变为奇数），写入数据后再加一（变为偶数）；
+    ///		读取者在读取前后序号相同且为偶数时认为读到了完整的数据，否则重试。
+    ///		数据按机器字逐个原子读写，因此对任意可平凡拷贝的类型都是无锁的，且读取者永远不会阻塞写入者。
+    /// @note 同一时刻只允许一个写入者，多个写入者需要在外部同步
+    template<typename TItem>
+        requires std::is_trivially_copyable_v<TItem> && std::default_initializable<TItem>
+    class alignas(cache_line_size) seqlock_item final {
+    public:
+        using item_type = TItem;
+
+    private:
+        using word_type = std::uintptr_t;
+        static_assert(std::atomic<word_type>::is_always_lock_free, "machine word must be lock free");
+
+        static constexpr size_type word_count = (sizeof(item_type) + sizeof(word_type) - 1) / sizeof(word_type);
+        using word_array = std::array<word_type, word_count>;
+
+        /// @brief 为 0 时表示还没有写入过数据。序号与数据放在一起，较小的类型只占用一个缓存行
+        std::atomic<std::uint64_t> sequence{0};
+        std::array<std::atomic<word_type>, word_count> words{};
+
+    public:
+        seqlock_item() = default;
+
+        explicit seqlock_item(const item_type &item) noexcept { set(item); }
+
+        seqlock_item(const seqlock_item &) = delete;
+        seqlock_item &operator=(const seqlock_item &) = delete;
+
+        /// @brief 是否已经写入过数据
+        [[nodiscard]] bool has_value() const noexcept {
+            return sequence.load(std::memory_order_acquire) != 0;
+        }
+
+        /// @brief 已经完成的写入次数，可用于判断数据是否有更新
+        [[nodiscard]] std::uint64_t version() const noexcept {
+            return sequence.load(std::memory_order_acquire) / 2;
+        }
+
+        /// @brief 读取最新值，还没有写入过数据时返回 false
+        bool get(item_type &result) const noexcept {
+            word_array buffer;
+            std::uint64_t begin;
+            while (true) {
+                begin = sequence.load(std::memory_order_acquire);
+                if (begin & 1) {
+                    cpu_relax();
+                    continue;
+                }
+                for (size_type i = 0; i < word_count; ++i)
+                    buffer[i] = words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == begin) break;
+            }
+            if (begin == 0) return false;
+            std::memcpy(&result, buffer.data(), sizeof(item_type));
+            return true;
+        }
+
+        bool set(const item_type &item) noexcept {
+            word_array buffer{};
+            std::memcpy(buffer.data(), &item, sizeof(item_type));
+
+            const auto current = sequence.load(std::memory_order_relaxed);
+            sequence.store(current + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_type i = 0; i < word_count; ++i)
+                words[i].store(buffer[i], std::memory_order_relaxed);
+            sequence.store(current + 2, std::memory_order_release);
+            return true;
+        }
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "basic_bytes.hpp"
+#include "cpu_hint.hpp"
+
+namespace ly::communicating {
+    /// @brief 队列已满时写入者的行为
+    enum class queue_full_policy {
+        /// @brief 写入失败，返回 false
+        fail,
+        /// @brief 丢弃最旧的数据，写入总是成功
+        overwrite,
+        /// @brief 自旋等待读取者腾出空间
+        spin
+    };
+
+    /// @brief 有界无锁单写单读环形队列，不会静默覆盖数据，可作为 @c reader_task 的投递位置与 @c writer_task 的来源
+    /// @details
+    ///		写入者与读取者各自缓存对方的下标，只有在缓存显示队列已满或为空时才读取对方的原子下标，
+    ///		两组下标分别位于不同的缓存行，避免伪共享。
+    /// @tparam capacity 队列容量，必须是 2 的幂次
+    /// @tparam policy 队列已满时的行为，@c queue_full_policy::overwrite 要求数据可平凡拷贝，
+    ///		此时写入者可能覆盖读取者正在读取的位置，因此每个位置按机器字原子读写，读到的值在下标校验失败时丢弃
+    template<typename TItem, size_type capacity, queue_full_policy policy = queue_full_policy::fail>
+        requires std::default_initializable<TItem> && std::is_copy_assignable_v<TItem>
+                 && (policy != queue_full_policy::overwrite || std::is_trivially_copyable_v<TItem>)
+    class spsc_queue final {
+        static_assert(std::has_single_bit(capacity), "capacity must be a power of two");
+
+    public:
+        using item_type = TItem;
+        static constexpr auto Capacity = capacity;
+        static constexpr auto Policy = policy;
+
+    private:
+        static constexpr size_type mask = capacity - 1;
+        static constexpr bool is_overwrite = policy == queue_full_policy::overwrite;
+
+        /// @brief 读取者的下标，覆盖模式下写入者也会推进它
+        alignas(cache_line_size) std::atomic<size_type> head{0};
+        size_type cached_tail{0};
+
+        /// @brief 写入者的下标
+        alignas(cache_line_size) std::atomic<size_type> tail{0};
+        size_type cached_head{0};
+        std::atomic<size_type> dropped{0};
+
+        using word_type = std::uintptr_t;
+        static constexpr size_type word_count = (sizeof(item_type) + sizeof(word_type) - 1) / sizeof(word_type);
+        using word_array = std::array<word_type, word_count>;
+        using slot_type = std::conditional_t<is_overwrite, std::array<std::atomic<word_type>, word_count>, item_type>;
+
+        alignas(cache_line_size) std::array<slot_type, capacity> items{};
+
+        void store_item(const size_type index, const item_type &item) noexcept {
+            if constexpr (is_overwrite) {
+                word_array buffer{};
+                std::memcpy(buffer.data(), &item, sizeof(item_type));
+                for (size_type i = 0; i < word_count; ++i)
+                    items[index & mask][i].store(buffer[i], std::memory_order_relaxed);
+            } else
+                items[index & mask] = item;
+        }
+
+        void load_item(const size_type index, item_type &item) const noexcept {
+            if constexpr (is_overwrite) {
+                word_array buffer;
+                for (size_type i = 0; i < word_count; ++i)
+                    buffer[i] = items[index & mask][i].load(std::memory_order_relaxed);
+                std::memcpy(&item, buffer.data(), sizeof(item_type));
+            } else
+                item = items[index & mask];
+        }
+
+        /// @brief 写入者计算剩余空间，仅在缓存显示空间不足 required 时读取读取者的下标
+        [[nodiscard]] size_type writable(const size_type current_tail, const size_type required) noexcept {
+            if (capacity - (current_tail - cached_head) < required)
+                cached_head = head.load(std::memory_order_acquire);
+            return capacity - (current_tail - cached_head);
+        }
+
+        /// @brief 读取者计算可读数量，仅在缓存显示数据不足 required 时读取写入者的下标
+        /// @note 覆盖模式下写入者推进的 head 可能越过读取者缓存的 tail
+        [[nodiscard]] size_type readable(const size_type current_head, const size_type required) noexcept {
+            if (current_head > cached_tail || cached_tail - current_head < required)
+                cached_tail = tail.load(std::memory_order_acquire);
+            return cached_tail - current_head;
+        }
+
+        /// @brief 覆盖模式下丢弃最旧的一个数据。读取者恰好同时读走了它时也视为腾出了空间
+        void drop_oldest() noexcept {
+            auto current_head = cached_head;
+            if (head.compare_exchange_strong(current_head, current_head + 1, std::memory_order_acq_rel)) {
+                cached_head = current_head + 1;
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            } else
+                cached_head = current_head;
+        }
+
+        /// @brief 为写入 required 个数据等待空间，返回可写数量，失败策略下可能小于 required
+        [[nodiscard]] size_type reserve(const size_type current_tail, const size_type required) noexcept {
+            auto free = writable(current_tail, required);
+            if constexpr (policy == queue_full_policy::spin) {
+                while (free == 0) {
+                    cpu_relax();
+                    free = writable(current_tail, required);
+                }
+            } else if constexpr (is_overwrite) {
+                if (free == 0) {
+                    drop_oldest();
+                    free = capacity - (current_tail - cached_head);
+                }
+            }
+            return free;
+        }
+
+    public:
+        spsc_queue() = default;
+
+        spsc_queue(const spsc_queue &) = delete;
+        spsc_queue &operator=(const spsc_queue &) = delete;
+
+        /// @brief 写入一个数据，仅在失败策略且队列已满时返回 false
+        bool push(const item_type &item) noexcept {
+            const auto current_tail = tail.load(std::memory_order_relaxed);
+            if (reserve(current_tail, 1) == 0) return false;
+            store_item(current_tail, item);
+            tail.store(current_tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief 批量写入，只发布一次下标
+        /// @return 写入的数量，仅在失败策略下可能小于 source.size()
+        size_type push_n(const std::span<const item_type> source) noexcept {
+            size_type pushed{0};
+            while (pushed < source.size()) {
+                const auto current_tail = tail.load(std::memory_order_relaxed);
+                const auto free = reserve(current_tail, source.size() - pushed);
+                if (free == 0) break;
+
+                const auto count = std::min(free, source.size() - pushed);
+                for (size_type i = 0; i < count; ++i)
+                    store_item(current_tail + i, source[pushed + i]);
+                tail.store(current_tail + count, std::memory_order_release);
+                pushed += count;
+            }
+            return pushed;
+        }
+
+        /// @brief 读取一个数据，队列为空时返回 false
+        bool pop(item_type &item) noexcept {
+            if constexpr (is_overwrite) {
+                // 写入者可能同时丢弃并改写了这个数据，此时读到的值作废，重新读取下一个
+                auto current_head = head.load(std::memory_order_acquire);
+                do {
+                    if (readable(current_head, 1) == 0) return false;
+                    load_item(current_head, item);
+                } while (!head.compare_exchange_weak(current_head, current_head + 1, std::memory_order_acq_rel));
+            } else {
+                const auto current_head = head.load(std::memory_order_relaxed);
+                if (readable(current_head, 1) == 0) return false;
+                load_item(current_head, item);
+                head.store(current_head + 1, std::memory_order_release);
+            }
+            return true;
+        }
+
+        /// @brief 批量读取，只发布一次下标
+        /// @return 读取的数量
+        size_type pop_n(const std::span<item_type> destination) noexcept {
+            if constexpr (is_overwrite) {
+                auto current_head = head.load(std::memory_order_acquire);
+                size_type count;
+                do {
+                    count = std::min(readable(current_head, destination.size()), destination.size());
+                    for (size_type i = 0; i < count; ++i)
+                        load_item(current_head + i, destination[i]);
+                } while (count != 0 && !head.compare_exchange_weak(
+                             current_head, current_head + count, std::memory_order_acq_rel));
+                return count;
+            } else {
+                const auto current_head = head.load(std::memory_order_relaxed);
+                const auto count = std::min(readable(current_head, destination.size()), destination.size());
+                for (size_type i = 0; i < count; ++i)
+                    load_item(current_head + i, destination[i]);
+                head.store(current_head + count, std::memory_order_release);
+                return count;
+            }
+        }
+
+        /// @brief 与 @c is_item_sink 兼容的写入接口
+        bool set(const item_type &item) noexcept { return push(item); }
+
+        /// @brief 与 @c is_item_source 兼容的读取接口
+        bool get(item_type &item) noexcept { return pop(item); }
+
+        /// @brief 队列中数据的近似数量，仅供观察
+        [[nodiscard]] size_type size() const noexcept {
+            const auto current_head = head.load(std::memory_order_acquire);
+            return tail.load(std::memory_order_acquire) - current_head;
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        /// @brief 覆盖模式下被丢弃的数据数量
+        [[nodiscard]] size_type dropped_count() const noexcept { return dropped.load(std::memory_order_relaxed); }
+    };
+}
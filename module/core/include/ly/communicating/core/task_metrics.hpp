@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+
+#include "basic_bytes.hpp"
+
+namespace ly::communicating {
+    /// @brief 对数分桶直方图的快照，可以在任意线程中计算分位数
+    /// @tparam bucket_count 桶数量，由 @c log_histogram 决定
+    template<size_type precision_bits, size_type bucket_count>
+    struct histogram_snapshot {
+        std::array<std::uint64_t, bucket_count> counts{};
+        std::uint64_t total{0};
+        std::uint64_t sum{0};
+        std::uint64_t max{0};
+
+        /// @brief 桶内最大的值
+        [[nodiscard]] static constexpr std::uint64_t upper_bound(const size_type index) noexcept {
+            constexpr size_type linear = size_type{2} << precision_bits;
+            if (index < linear) return index;
+            const auto magnitude = (index - linear) >> precision_bits;
+            const auto sub = (index - linear) & ((size_type{1} << precision_bits) - 1);
+            const auto shift = magnitude + 1;
+            const auto low = ((std::uint64_t{1} << precision_bits) + sub) << shift;
+            return low + (std::uint64_t{1} << shift) - 1;
+        }
+
+        /// @brief 分位数，返回所在桶的上界，相对误差不超过 2^-precision_bits
+        /// @param ratio 0 到 1 之间，例如 0.99
+        [[nodiscard]] std::uint64_t percentile(const double ratio) const noexcept {
+            if (total == 0) return 0;
+            const auto target = static_cast<std::uint64_t>(ratio * static_cast<double>(total - 1)) + 1;
+            std::uint64_t seen{0};
+            for (size_type i = 0; i < bucket_count; ++i) {
+                seen += counts[i];
+                if (seen >= target) return std::min(upper_bound(i), max);
+            }
+            return max;
+        }
+
+        [[nodiscard]] double mean() const noexcept {
+            return total == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(total);
+        }
+    };
+
+    namespace details {
+        /// @brief 单写者计数器自增，写入方只有一个线程时不需要带锁前缀的读改写指令
+        inline void single_writer_add(std::atomic<std::uint64_t> &counter, const std::uint64_t value) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief HDR 风格的对数线性分桶直方图，记录非负整数（例如纳秒）
+    /// @details
+    ///		小于 2^(precision_bits+1) 的值每个值一个桶，更大的值在每个 2 的幂区间内再均分为 2^precision_bits 个桶，
+    ///		因此相对误差固定，桶数量与值域的对数成正比。记录只是一次数组下标计算与一次原子存储。
+    /// @note 只允许一个线程调用 record ，其他线程可以随时调用 snapshot ，快照中各个桶之间不保证是同一时刻的值
+    template<size_type precision_bits = 4>
+        requires (precision_bits >= 1 && precision_bits <= 8)
+    class log_histogram {
+        static constexpr size_type linear = size_type{2} << precision_bits;
+
+    public:
+        static constexpr size_type bucket_count = linear + (64 - precision_bits - 1) * (size_type{1} << precision_bits);
+        using snapshot_type = histogram_snapshot<precision_bits, bucket_count>;
+
+        [[nodiscard]] static constexpr size_type index_of(const std::uint64_t value) noexcept {
+            if (value < linear) return static_cast<size_type>(value);
+            const auto msb = static_cast<size_type>(std::bit_width(value)) - 1;
+            const auto shift = msb - precision_bits;
+            const auto sub = static_cast<size_type>(value >> shift) - (size_type{1} << precision_bits);
+            return linear + ((msb - precision_bits - 1) << precision_bits) + sub;
+        }
+
+        void record(const std::uint64_t value) noexcept {
+            details::single_writer_add(counts[index_of(value)], 1);
+            details::single_writer_add(sum, value);
+            if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+        }
+
+        /// @brief 总数由各个桶累加得到，记录时不单独维护
+        [[nodiscard]] snapshot_type snapshot() const noexcept {
+            snapshot_type result{};
+            for (size_type i = 0; i < bucket_count; ++i) {
+                result.counts[i] = counts[i].load(std::memory_order_relaxed);
+                result.total += result.counts[i];
+            }
+            result.sum = sum.load(std::memory_order_relaxed);
+            result.max = max.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, bucket_count> counts{};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> max{0};
+    };
+
+    /// @brief 任务度量接口
+    /// @details
+    ///		任务在每次 run_once 开始时调用 start 得到时间戳，每个阶段成功后调用 lap 记录该阶段耗时，
+    ///		失败时调用 fail 记录失败码并原样返回，一帧完成后调用 done 记录字节数。
+    template<typename object_type>
+    concept is_task_metrics = requires(object_type &object, typename object_type::stamp_type &stamp, size_type value) {
+        { object.start() } -> std::same_as<typename object_type::stamp_type>;
+        { object.lap(stamp, value) } -> std::same_as<void>;
+        { object.fail(static_cast<int>(value)) } -> std::same_as<int>;
+        { object.done(value) } -> std::same_as<void>;
+    };
+
+    /// @brief 不记录任何度量，所有函数都是空的内联函数，在任务中以 [[no_unique_address]] 保存，不占用空间
+    struct no_metrics {
+        struct stamp_type {};
+
+        static stamp_type start() noexcept { return {}; }
+        static void lap(stamp_type &, size_type) noexcept {}
+        static int fail(const int result) noexcept { return result; }
+        static void done(size_type) noexcept {}
+    };
+
+    /// @brief 任务度量快照
+    template<typename histogram_type>
+    struct task_metrics_snapshot {
+        /// @brief 各阶段成功时的耗时，单位纳秒。读取任务依次为 read、pack、set ，写入任务依次为 get、unpack、write
+        std::array<typename histogram_type::snapshot_type, 3> stages{};
+        /// @brief 各失败码出现的次数，下标为 -basic_task_failure - 1
+        std::array<std::uint64_t, 6> failures{};
+        std::uint64_t frames{0};
+        std::uint64_t bytes{0};
+
+        [[nodiscard]] std::uint64_t failure_count(const int code) const noexcept {
+            const auto index = -code - 1;
+            return index >= 0 && index < static_cast<int>(failures.size()) ? failures[index] : 0;
+        }
+    };
+
+    /// @brief 无锁任务度量：每个阶段一个 @c log_histogram ，每个失败码一个计数器，以及帧数与字节数
+    /// @details 由任务所在线程写入，其他线程通过 snapshot 随时读取，不需要暂停任务
+    /// @tparam clock_type 计时使用的时钟，默认 steady_clock ，在 Linux 上通过 vDSO 读取，不产生系统调用
+    template<typename clock_type = std::chrono::steady_clock, size_type precision_bits = 4>
+    class task_metrics {
+        using histogram_type = log_histogram<precision_bits>;
+
+        std::array<histogram_type, 3> stages{};
+        std::array<std::atomic<std::uint64_t>, 6> failures{};
+        std::atomic<std::uint64_t> frames{0};
+        std::atomic<std::uint64_t> bytes{0};
+
+    public:
+        using stamp_type = typename clock_type::time_point;
+        using snapshot_type = task_metrics_snapshot<histogram_type>;
+
+        static stamp_type start() noexcept { return clock_type::now(); }
+
+        void lap(stamp_type &stamp, const size_type stage) noexcept {
+            const auto now = clock_type::now();
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - stamp).count();
+            stages[stage].record(elapsed > 0 ? static_cast<std::uint64_t>(elapsed) : 0);
+            stamp = now;
+        }
+
+        int fail(const int result) noexcept {
+            const auto index = -result - 1;
+            if (index >= 0 && index < static_cast<int>(failures.size()))
+                details::single_writer_add(failures[index], 1);
+            return result;
+        }
+
+        void done(const size_type frame_bytes) noexcept {
+            details::single_writer_add(frames, 1);
+            details::single_writer_add(bytes, frame_bytes);
+        }
+
+        [[nodiscard]] snapshot_type snapshot() const noexcept {
+            snapshot_type result{};
+            for (size_type i = 0; i < stages.size(); ++i) result.stages[i] = stages[i].snapshot();
+            for (size_type i = 0; i < failures.size(); ++i) result.failures[i] = failures[i].load(std::memory_order_relaxed);
+            result.frames = frames.load(std::memory_order_relaxed);
+            result.bytes = bytes.load(std::memory_order_relaxed);
+            return result;
+        }
+    };
+}
@@ -5,21 +5,64 @@
 #include <atomic>
 #include <concepts>
 #include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "cpu_hint.hpp"
 
 namespace cango::utility {
+    using ly::communicating::cache_line_size;
+
     template<typename item_type>
     using triple_item_array = std::array<item_type, 3>;
 
     namespace details {
+        /// @brief 无等待三缓冲的下标管理
+        /// @details
+        ///		三个槽位分别由写入者、读取者独占一个，剩下的一个作为中转，中转槽位的下标与“有新数据”标志存放在同一个原子字节中。
+        ///		写入者写完自己的槽位后，用一次原子交换把它与中转槽位互换并置位标志；
+        ///		读取者发现标志置位时，用一次原子交换把自己的槽位与中转槽位互换并清除标志。
+        ///		双方都只有一次原子操作，没有循环，因此是无等待的，且读取者拿到的总是最新写入的数据。
+        /// @note 只支持单写入者、单读取者
         struct triple_item_pool_utils {
             enum usage_flag : std::uint8_t {
-                Empty = 0,
-                Full  = 1,
-                Busy  = 2
+                IndexMask = 0b011,
+                Fresh     = 0b100
             };
 
-            std::atomic_uint8_t writer_index{0};
-            triple_item_array<std::atomic_uint8_t> flags{};
+            /// @brief 中转槽位下标与新数据标志，被双方共享
+            alignas(cache_line_size) std::atomic_uint8_t middle_state{1};
+            /// @brief 写入者独占
+            alignas(cache_line_size) std::uint8_t writer_index{0};
+            std::uint64_t writer_sequence{0};
+            /// @brief 读取者独占
+            alignas(cache_line_size) std::uint8_t reader_index{2};
+
+            /// @brief 写入者写完 writer_index 对应的槽位后调用，发布数据并换回一个空闲槽位
+            void publish() noexcept {
+                const auto previous = middle_state.exchange(writer_index | Fresh, std::memory_order_acq_rel);
+                writer_index = previous & IndexMask;
+            }
+
+            /// @brief 读取者调用，有新数据时换到 reader_index 并返回 true
+            [[nodiscard]] bool acquire() noexcept {
+                if (!(middle_state.load(std::memory_order_relaxed) & Fresh)) return false;
+                const auto previous = middle_state.exchange(reader_index, std::memory_order_acq_rel);
+                reader_index = previous & IndexMask;
+                return true;
+            }
+
+            /// @brief 是否有尚未读取的新数据，不需要拷贝数据
+            [[nodiscard]] bool has_fresh() const noexcept {
+                return middle_state.load(std::memory_order_acquire) & Fresh;
+            }
+        };
+
+        /// @brief 按缓存行对齐的槽位，sequence 为写入序号，从 1 开始
+        template<typename item_type>
+        struct alignas(cache_line_size) triple_slot {
+            item_type item{};
+            std::uint64_t sequence{0};
         };
     }
 
@@ -27,61 +70,54 @@ namespace cango::utility {
     class nonblock_triple_byte_pool final : details::triple_item_pool_utils {
         static_assert(sizeof(char) == sizeof(std::uint8_t), "byte size assertion failed");
 
-        std::array<std::array<std::uint8_t, item_size>, 3> items{};
+        triple_item_array<details::triple_slot<std::array<std::uint8_t, item_size>>> slots{};
 
     public:
+        using triple_item_pool_utils::has_fresh;
+
         template<typename item_type>
             requires std::is_trivially_copyable_v<item_type> && (sizeof(item_type) == item_size)
         void push(const item_type &item) noexcept {
-            std::uint8_t index{writer_index};
-            std::uint8_t busy;
-            do {
-                busy = Busy;
-                index = (index + 1) % 3;
-            }
-            while (flags[index].compare_exchange_weak(busy, Busy));
-            std::memcpy(items[index].data(), &item, item_size);
-            flags[index] = Full;
-            writer_index = index;
+            auto &slot = slots[writer_index];
+            std::memcpy(slot.item.data(), &item, item_size);
+            slot.sequence = ++writer_sequence;
+            publish();
         }
 
         template<typename item_type>
             requires std::is_trivially_copyable_v<item_type> && (sizeof(item_type) == item_size)
         [[nodiscard]] bool pop(item_type &item) noexcept {
-            for (std::uint8_t index = 0; index < 3; ++index) {
-                if (std::uint8_t full = Full;
-                    !flags[index].compare_exchange_weak(full, Busy))
-                    continue;
-                std::memcpy(&item, items[index].data(), item_size);
-                flags[index] = Empty;
-                return true;
-            }
-            return false;
+            if (!acquire()) return false;
+            std::memcpy(&item, slots[reader_index].item.data(), item_size);
+            return true;
         }
+
+        /// @brief 最近一次 pop 得到的数据的写入序号，序号不连续说明中间有数据被覆盖
+        [[nodiscard]] std::uint64_t sequence() const noexcept { return slots[reader_index].sequence; }
     };
 
     class nonblock_triple_byte_pool_dynamic final : details::triple_item_pool_utils {
-        std::array<std::vector<std::uint8_t>, 3> items{};
+        triple_item_array<details::triple_slot<std::vector<std::uint8_t>>> slots{};
 
     public:
-        [[nodiscard]] std::size_t get_item_size() const noexcept { return items[0].size(); }
-        void set_item_size() noexcept { std::ranges::for_each(items, [](auto &item) { item.resize(0); }); }
+        using triple_item_pool_utils::has_fresh;
+
+        [[nodiscard]] std::size_t get_item_size() const noexcept { return slots[0].item.size(); }
+
+        /// @brief 设置数据大小，必须在读写开始之前调用
+        void set_item_size(const std::size_t item_size) {
+            std::ranges::for_each(slots, [item_size](auto &slot) { slot.item.resize(item_size); });
+        }
 
         template<typename item_type>
             requires std::is_trivially_copyable_v<item_type>
         void push(const item_type &item) noexcept {
             if (sizeof(item_type) != get_item_size()) return;
 
-            std::uint8_t index{writer_index};
-            std::uint8_t busy;
-            do {
-                busy = Busy;
-                index = (index + 1) % 3;
-            }
-            while (flags[index].compare_exchange_weak(busy, Busy));
-            std::memcpy(items[index], &item, get_item_size());
-            flags[index] = Full;
-            writer_index = index;
+            auto &slot = slots[writer_index];
+            std::memcpy(slot.item.data(), &item, sizeof(item_type));
+            slot.sequence = ++writer_sequence;
+            publish();
         }
 
         template<typename item_type>
@@ -89,47 +125,48 @@ namespace cango::utility {
         [[nodiscard]] bool pop(item_type &item) noexcept {
             if (sizeof(item_type) != get_item_size()) return false;
 
-            for (std::uint8_t index = 0; index < 3; ++index) {
-                if (std::uint8_t full = Full;
-                    !flags[index].compare_exchange_weak(full, Busy))
-                    continue;
-                std::memcpy(&item, items[index], get_item_size());
-                flags[index] = Empty;
-                return true;
-            }
-            return false;
+            if (!acquire()) return false;
+            std::memcpy(&item, slots[reader_index].item.data(), sizeof(item_type));
+            return true;
         }
+
+        [[nodiscard]] std::uint64_t sequence() const noexcept { return slots[reader_index].sequence; }
     };
 
-    template<typename item_type>
-        requires std::default_initializable<item_type> && std::is_copy_assignable_v<item_type>
+    template<typename TItem>
+        requires std::default_initializable<TItem> && std::is_copy_assignable_v<TItem>
     class nonblock_triple_item_pool final : details::triple_item_pool_utils {
-        triple_item_array<item_type> items{};
+    public:
+        using item_type = TItem;
+
+    private:
+        triple_item_array<details::triple_slot<item_type>> slots{};
 
     public:
+        using triple_item_pool_utils::has_fresh;
+
         void push(const item_type &item) noexcept {
-            std::uint8_t index{writer_index};
-            std::uint8_t busy;
-            do {
-                busy = Busy;
-                index = (index + 1) % 3;
-            }
-            while (flags[index].compare_exchange_weak(busy, Busy));
-            items[index] = item;
-            flags[index] = Full;
-            writer_index = index;
+            auto &slot = slots[writer_index];
+            slot.item = item;
+            slot.sequence = ++writer_sequence;
+            publish();
         }
 
         [[nodiscard]] bool pop(item_type &item) noexcept {
-            for (std::uint8_t index = 0; index < 3; ++index) {
-                if (std::uint8_t full = Full;
-                    !flags[index].compare_exchange_weak(full, Busy))
-                    continue;
-                item = items[index];
-                flags[index] = Empty;
-                return true;
-            }
-            return false;
+            if (!acquire()) return false;
+            item = slots[reader_index].item;
+            return true;
         }
+
+        [[nodiscard]] std::uint64_t sequence() const noexcept { return slots[reader_index].sequence; }
+
+        /// @brief 与 @c is_item_sink 兼容的写入接口
+        bool set(const item_type &item) noexcept {
+            push(item);
+            return true;
+        }
+
+        /// @brief 与 @c is_item_source 兼容的读取接口，没有新数据时返回 false
+        bool get(item_type &item) noexcept { return pop(item); }
     };
 }
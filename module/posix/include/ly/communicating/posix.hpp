@@ -0,0 +1,9 @@
+#pragma once
+
+#include "posix/capture.hpp"
+#include "posix/coroutine_executor.hpp"
+#include "posix/event_loop.hpp"
+#include "posix/fd_rwer.hpp"
+#include "posix/realtime_thread.hpp"
+#include "posix/serial_port.hpp"
+#include "posix/uring.hpp"
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/byte_rwer.hpp>
+#include <ly/communicating/core/cpu_hint.hpp>
+
+#include "fd_rwer.hpp"
+
+namespace ly::communicating::posix {
+    /// @brief 捕获记录的方向
+    enum class capture_direction : std::uint8_t {
+        read = 1,
+        write = 2
+    };
+
+    namespace details {
+        inline constexpr char capture_magic[8] = {'L', 'Y', 'C', 'A', 'P', 'T', '0', '1'};
+
+        /// @brief 捕获文件头，位于文件开头，占 64 字节
+        struct capture_file_header {
+            char magic[8];
+            std::uint64_t capacity;
+            /// @brief 捕获开始时的 CLOCK_REALTIME ，单位纳秒，便于与日志对齐
+            std::int64_t realtime_ns;
+            std::uint64_t reserved[5];
+        };
+
+        static_assert(sizeof(capture_file_header) == 64);
+
+        /// @brief 记录头，其后为 size 字节数据，整条记录按 8 字节对齐
+        /// @details
+        ///		size 在预留空间后立即写入，为 0 表示已到达末尾；committed 在数据写完后以 release 写入，
+        ///		为 0 表示该记录尚未写完，回放时按 size 跳过，不影响其后已经写完的记录。
+        struct capture_record_header {
+            /// @brief 相对捕获开始的时间，单位纳秒
+            std::uint64_t timestamp_ns;
+            std::uint32_t size;
+            capture_direction direction;
+            std::uint8_t committed;
+            std::uint8_t reserved[2];
+        };
+
+        static_assert(sizeof(capture_record_header) == 16);
+
+        [[nodiscard]] constexpr size_type capture_record_size(const size_type data_size) noexcept {
+            return sizeof(capture_record_header) + ((data_size + 7) & ~size_type{7});
+        }
+
+        /// @brief 只读或读写映射整个文件，析构时解除映射并关闭文件
+        class mapped_file {
+            int fd{-1};
+            byte_type *data{nullptr};
+            size_type size{0};
+
+        public:
+            mapped_file(const int fd, const size_type size, const int protection, const int flags) : size(size) {
+                auto *address = ::mmap(nullptr, size, protection, flags, fd, 0);
+                if (address == MAP_FAILED) {
+                    const auto error = errno;
+                    ::close(fd);
+                    errno = error;
+                    throw_errno("mmap");
+                }
+                this->fd = fd;
+                data = static_cast<byte_type *>(address);
+            }
+
+            mapped_file(const mapped_file &) = delete;
+            mapped_file &operator=(const mapped_file &) = delete;
+
+            ~mapped_file() {
+                ::munmap(data, size);
+                ::close(fd);
+            }
+
+            [[nodiscard]] byte_type *get() const noexcept { return data; }
+            [[nodiscard]] size_type get_size() const noexcept { return size; }
+        };
+    }
+
+    /// @brief 预分配并映射到内存的捕获文件，热路径上只有一次原子预留（竞争时重试）、一次时钟读取与一次内存拷贝
+    /// @details
+    ///		文件在创建时通过 posix_fallocate 分配全部空间，映射后逐页预先写入，热路径上不会扩展文件，也不会产生缺页，
+    ///		代价是创建时间与容量成正比。
+    ///		多个线程可以同时写入同一个文件，空间不足时丢弃记录并计入 @c get_dropped_count 。
+    ///		数据由内核在后台写回，进程崩溃时已经写完的记录不会丢失：正在写入的记录没有提交标记，回放时被跳过。
+    ///		只有崩溃恰好发生在预留空间与写入长度之间的几条指令内时，回放会停在这条记录处。
+    class capture_file {
+        std::unique_ptr<details::mapped_file> map;
+        std::chrono::steady_clock::time_point start;
+        alignas(64) std::atomic<size_type> used{sizeof(details::capture_file_header)};
+        std::atomic<size_type> dropped{0};
+
+    public:
+        /// @param capacity 记录区的字节数，不含文件头
+        /// @exception std::system_error 无法创建、分配或映射文件时抛出异常
+        capture_file(const std::string &path, const size_type capacity) :
+            start(std::chrono::steady_clock::now()) {
+            const auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) details::throw_errno("open");
+            const auto size = sizeof(details::capture_file_header) + capacity;
+            if (const auto error = ::posix_fallocate(fd, 0, static_cast<off_t>(size)); error != 0) {
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "posix_fallocate");
+            }
+            map = std::make_unique<details::mapped_file>(fd, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE);
+            // 共享文件映射的页面第一次写入时仍会产生一次写保护缺页，在创建时逐页写入一次，使热路径上不再缺页
+            const auto page_size = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+            for (size_type offset = 0; offset < size; offset += page_size)
+                std::atomic_ref{map->get()[offset]}.store(0, std::memory_order_relaxed);
+
+            details::capture_file_header header{};
+            std::memcpy(header.magic, details::capture_magic, sizeof(header.magic));
+            header.capacity = capacity;
+            header.realtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            std::memcpy(map->get(), &header, sizeof(header));
+        }
+
+        /// @brief 追加一条记录，可以在任意线程调用
+        /// @return 空间不足时返回 false
+        bool append(const capture_direction direction, const const_byte_span data) noexcept {
+            if (data.empty()) return true;
+            if (data.size() > std::numeric_limits<std::uint32_t>::max()) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            const auto record_size = details::capture_record_size(data.size());
+            // 只在记录放得下时推进 used ，失败时不回退，其他线程预留的区间不会被重复分配，也不会留下空洞
+            auto offset = used.load(std::memory_order_relaxed);
+            do {
+                if (offset + record_size > map->get_size()) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (!used.compare_exchange_weak(offset, offset + record_size, std::memory_order_relaxed));
+
+            auto *record = map->get() + offset;
+            auto *header = reinterpret_cast<details::capture_record_header *>(record);
+            std::atomic_ref{header->size}.store(static_cast<std::uint32_t>(data.size()), std::memory_order_relaxed);
+            header->timestamp_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            header->direction = direction;
+            std::memcpy(record + sizeof(details::capture_record_header), data.data(), data.size());
+            std::atomic_ref{header->committed}.store(1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief 已使用的字节数，含文件头
+        [[nodiscard]] size_type get_used() const noexcept { return used.load(std::memory_order_relaxed); }
+
+        /// @brief 因空间不足被丢弃的记录数量
+        [[nodiscard]] size_type get_dropped_count() const noexcept { return dropped.load(std::memory_order_relaxed); }
+    };
+
+    /// @brief 捕获包装读取器，将内部读取器返回的每一段字节追加到捕获文件
+    /// @tparam reader_type 被包装的读取器，为具体的 final 类型时调用不经过虚函数
+    template<typename reader_type = byte_reader>
+        requires is_reader<reader_type>
+    class capture_reader final : public byte_reader {
+        std::shared_ptr<reader_type> reader;
+        std::shared_ptr<capture_file> file;
+
+    public:
+        capture_reader(std::shared_ptr<reader_type> reader, std::shared_ptr<capture_file> file) :
+            reader(std::move(reader)), file(std::move(file)) {}
+
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            const auto bytes = reader->read(buffer);
+            if (bytes > 0) file->append(capture_direction::read, buffer.first(bytes));
+            return bytes;
+        }
+    };
+
+    /// @brief 捕获包装写入器，将内部写入器实际写出的字节追加到捕获文件
+    template<typename writer_type = byte_writer>
+        requires is_writer<writer_type>
+    class capture_writer final : public byte_writer {
+        std::shared_ptr<writer_type> writer;
+        std::shared_ptr<capture_file> file;
+
+    public:
+        capture_writer(std::shared_ptr<writer_type> writer, std::shared_ptr<capture_file> file) :
+            writer(std::move(writer)), file(std::move(file)) {}
+
+        [[nodiscard]] size_type write(const const_byte_span buffer) override {
+            const auto bytes = writer->write(buffer);
+            if (bytes > 0) file->append(capture_direction::write, buffer.first(bytes));
+            return bytes;
+        }
+    };
+
+    /// @brief 捕获包装读写器，两个方向写入同一个捕获文件，以记录方向区分
+    template<typename rwer_type = byte_rwer>
+        requires is_rwer<rwer_type>
+    class capture_rwer final : public byte_rwer {
+        std::shared_ptr<rwer_type> rwer;
+        std::shared_ptr<capture_file> file;
+
+    public:
+        capture_rwer(std::shared_ptr<rwer_type> rwer, std::shared_ptr<capture_file> file) :
+            rwer(std::move(rwer)), file(std::move(file)) {}
+
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            const auto bytes = rwer->read(buffer);
+            if (bytes > 0) file->append(capture_direction::read, buffer.first(bytes));
+            return bytes;
+        }
+
+        [[nodiscard]] size_type write(const const_byte_span buffer) override {
+            const auto bytes = rwer->write(buffer);
+            if (bytes > 0) file->append(capture_direction::write, buffer.first(bytes));
+            return bytes;
+        }
+    };
+
+    /// @brief 回放读取器，映射捕获文件并按原速、倍速或全速输出其中一个方向的记录
+    /// @details
+    ///		speed 为 0 时全速回放，read 会跨记录填满缓冲区；否则按记录的时间戳除以 speed 等待到达时间，
+    ///		每次 read 最多输出一条记录，保持原始的分段。与 @c fd_rwer 一样，记录尚未到达时 read 最多等待 read_timeout ，
+    ///		仍未到达或已经回放完毕时返回 0 。
+    ///		@c next_chunk 直接返回映射内存中的区间，解码器可以不经拷贝地处理捕获数据。
+    class replay_reader final : public byte_reader {
+        std::unique_ptr<details::mapped_file> map;
+        capture_direction direction;
+        double speed;
+        std::chrono::milliseconds read_timeout;
+        std::chrono::steady_clock::time_point start;
+
+        /// @brief 下一条记录的偏移，以及当前记录已输出的字节数
+        size_type offset{sizeof(details::capture_file_header)};
+        size_type consumed{0};
+
+        [[nodiscard]] const details::capture_record_header *record() const noexcept {
+            if (offset + sizeof(details::capture_record_header) > map->get_size()) return nullptr;
+            const auto *header = reinterpret_cast<const details::capture_record_header *>(map->get() + offset);
+            if (header->size == 0 || offset + details::capture_record_size(header->size) > map->get_size()) return nullptr;
+            return header;
+        }
+
+        /// @brief 跳过其他方向以及没有写完的记录，返回下一条可以输出的记录
+        [[nodiscard]] const details::capture_record_header *next_record() noexcept {
+            while (const auto *header = record()) {
+                if (header->committed != 0 && header->direction == direction) return header;
+                offset += details::capture_record_size(header->size);
+                consumed = 0;
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] std::chrono::steady_clock::time_point due_time(const details::capture_record_header &header) const noexcept {
+            return start + std::chrono::nanoseconds{static_cast<std::int64_t>(static_cast<double>(header.timestamp_ns) / speed)};
+        }
+
+        [[nodiscard]] bool is_due(const details::capture_record_header &header) const noexcept {
+            return speed <= 0 || std::chrono::steady_clock::now() >= due_time(header);
+        }
+
+        /// @brief 休眠到 deadline 之前 spin_margin 处，剩余时间忙等，避免定时器精度使回放间隔整体偏大
+        static void wait_until(const std::chrono::steady_clock::time_point deadline) noexcept {
+            constexpr auto spin_margin = std::chrono::microseconds{100};
+            if (deadline - std::chrono::steady_clock::now() > spin_margin)
+                std::this_thread::sleep_until(deadline - spin_margin);
+            while (std::chrono::steady_clock::now() < deadline) cpu_relax();
+        }
+
+        void advance(const details::capture_record_header &header, const size_type bytes) noexcept {
+            consumed += bytes;
+            if (consumed == header.size) {
+                offset += details::capture_record_size(header.size);
+                consumed = 0;
+            }
+        }
+
+    public:
+        /// @param speed 回放速度倍数，1 为原速，0 为全速
+        /// @exception std::system_error 无法打开或映射文件时抛出异常
+        /// @exception std::invalid_argument 文件不是捕获文件时抛出异常
+        explicit replay_reader(const std::string &path,
+            const capture_direction direction = capture_direction::read, const double speed = 0,
+            const std::chrono::milliseconds read_timeout = std::chrono::milliseconds{10}) :
+            direction(direction), speed(speed), read_timeout(read_timeout) {
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) details::throw_errno("open");
+            struct stat status{};
+            if (::fstat(fd, &status) != 0 || static_cast<size_type>(status.st_size) < sizeof(details::capture_file_header)) {
+                ::close(fd);
+                throw std::invalid_argument("capture file is too small");
+            }
+            map = std::make_unique<details::mapped_file>(fd, static_cast<size_type>(status.st_size), PROT_READ,
+                MAP_PRIVATE | MAP_POPULATE);
+            ::madvise(map->get(), map->get_size(), MADV_SEQUENTIAL);
+            if (std::memcmp(map->get(), details::capture_magic, sizeof(details::capture_magic)) != 0)
+                throw std::invalid_argument("not a capture file");
+            rewind();
+        }
+
+        /// @brief 从头开始回放，并以当前时刻作为时间零点
+        void rewind() noexcept {
+            offset = sizeof(details::capture_file_header);
+            consumed = 0;
+            start = std::chrono::steady_clock::now();
+        }
+
+        /// @brief 是否已经回放完毕
+        [[nodiscard]] bool finished() noexcept { return next_record() == nullptr; }
+
+        /// @brief 返回当前记录中尚未输出的部分，不拷贝；记录尚未到达或已经回放完毕时返回空区间
+        [[nodiscard]] const_byte_span next_chunk() noexcept {
+            const auto *header = next_record();
+            if (header == nullptr || !is_due(*header)) return {};
+            const const_byte_span chunk{
+                map->get() + offset + sizeof(details::capture_record_header) + consumed, header->size - consumed};
+            advance(*header, chunk.size());
+            return chunk;
+        }
+
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            if (speed > 0) {
+                const auto *header = next_record();
+                if (header == nullptr) return 0;
+                wait_until(std::min(due_time(*header), std::chrono::steady_clock::now() + read_timeout));
+            }
+            size_type bytes{0};
+            while (bytes < buffer.size()) {
+                const auto *header = next_record();
+                if (header == nullptr || !is_due(*header)) break;
+                const auto size = std::min(buffer.size() - bytes, header->size - consumed);
+                std::memcpy(buffer.data() + bytes,
+                    map->get() + offset + sizeof(details::capture_record_header) + consumed, size);
+                advance(*header, size);
+                bytes += size;
+                if (speed > 0) break;
+            }
+            return bytes;
+        }
+    };
+}
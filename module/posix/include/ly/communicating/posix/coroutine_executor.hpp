@@ -0,0 +1,508 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/async_task.hpp>
+#include <ly/communicating/core/basic_tasks.hpp>
+
+#include "event_loop.hpp"
+#include "fd_rwer.hpp"
+
+namespace ly::communicating::posix {
+    /// @brief 取出包裹成功后通知事件循环的包裹来源，与 @c notifying_sink 对称，用于唤醒等待队列空位的写入方
+    template<typename source_type>
+        requires is_item_source<source_type>
+    class notifying_source {
+        std::shared_ptr<source_type> source;
+        std::shared_ptr<event_notifier> notifier;
+
+    public:
+        using item_type = typename source_type::item_type;
+
+        notifying_source(std::shared_ptr<source_type> source, std::shared_ptr<event_notifier> notifier) :
+            source(std::move(source)), notifier(std::move(notifier)) {}
+
+        bool get(item_type &item) noexcept {
+            if (!source->get(item)) return false;
+            notifier->notify();
+            return true;
+        }
+    };
+
+    template<typename object_type>
+    concept is_native_handle = requires(const object_type &object) {
+        { object.native_handle() } -> std::convertible_to<int>;
+    };
+
+    namespace details {
+        [[nodiscard]] inline int native_fd(const int fd) noexcept { return fd; }
+
+        template<is_native_handle object_type>
+        [[nodiscard]] int native_fd(const object_type &object) noexcept { return object.native_handle(); }
+
+        constexpr size_type no_timer = std::numeric_limits<size_type>::max();
+
+        struct fd_state;
+
+        /// @brief 挂起中的异步操作，位于等待者的协程帧中，地址在挂起期间不变
+        struct async_operation {
+            std::coroutine_handle<> handle;
+            /// @brief fd 就绪后再次尝试，完成（包括出错）时返回 true ，仍需等待时返回 false
+            bool (*attempt)(async_operation &) noexcept {nullptr};
+            fd_state *waiting{nullptr};
+            bool is_writer{false};
+            size_type timer{no_timer};
+        };
+
+        /// @brief 每个 fd 最多一个等待可读与一个等待可写的操作
+        struct fd_state {
+            int fd{-1};
+            async_operation *reader{nullptr};
+            async_operation *writer{nullptr};
+        };
+    }
+
+    /// @brief 单线程协程执行器，由 epoll 驱动，在一个线程中运行大量 @c async_task 会话
+    /// @details
+    ///		读写、取出、投递等待对象先直接尝试，成功时不挂起，也不产生任何系统调用；
+    ///		失败时挂起，并以 EPOLLONESHOT 注册所需的事件，fd 就绪后再次尝试，完成后恢复等待者。
+    ///		每个 fd 在首次等待时加入 epoll ，之后只修改关注的事件。定时器为小根堆，取消时只增加槽位的代数，不搜索堆。
+    ///		挂起的操作位于等待者的协程帧中，就绪队列与定时器堆在预热后不再扩容，稳定运行时每帧数据不分配内存。
+    /// @note 执行器与其中的协程都只能在运行 @c run 的线程中使用，@c stop 可以在任意线程调用。
+    ///		同一个 fd 同时最多一个协程等待读、一个协程等待写；关闭 fd 之前应调用 @c forget 。
+    class coroutine_executor {
+        using clock_type = std::chrono::steady_clock;
+
+        struct timer_slot {
+            details::async_operation *operation{nullptr};
+            std::uint64_t generation{0};
+        };
+
+        struct timer_entry {
+            clock_type::time_point deadline;
+            size_type slot;
+            std::uint64_t generation;
+        };
+
+        int epoll_fd{-1};
+        int stop_fd{-1};
+        std::atomic<bool> stopping{false};
+        size_type live_count{0};
+
+        std::unordered_map<int, details::fd_state> fds;
+        std::vector<std::coroutine_handle<>> ready;
+        std::vector<std::coroutine_handle<>> running;
+        std::vector<epoll_event> events;
+
+        std::vector<timer_slot> timer_slots;
+        std::vector<size_type> free_slots;
+        std::vector<timer_entry> timers;
+
+        void arm(details::fd_state &state) noexcept {
+            epoll_event event{};
+            event.events = EPOLLONESHOT;
+            if (state.reader != nullptr) event.events |= EPOLLIN;
+            if (state.writer != nullptr) event.events |= EPOLLOUT;
+            event.data.ptr = &state;
+            ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, state.fd, &event);
+        }
+
+        details::fd_state &state_of(const int fd) {
+            const auto [iterator, inserted] = fds.try_emplace(fd);
+            auto &state = iterator->second;
+            if (inserted) {
+                state.fd = fd;
+                epoll_event event{};
+                event.events = EPOLLONESHOT;
+                event.data.ptr = &state;
+                if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                    fds.erase(iterator);
+                    details::throw_errno("epoll_ctl");
+                }
+            }
+            return state;
+        }
+
+        void start_timer(details::async_operation &operation, const std::chrono::milliseconds timeout) {
+            size_type slot;
+            if (free_slots.empty()) {
+                slot = timer_slots.size();
+                timer_slots.emplace_back();
+            } else {
+                slot = free_slots.back();
+                free_slots.pop_back();
+            }
+            timer_slots[slot].operation = &operation;
+            operation.timer = slot;
+            timers.push_back({clock_type::now() + timeout, slot, timer_slots[slot].generation});
+            // 以 greater 比较截止时刻，最早的在堆顶
+            std::ranges::push_heap(timers, std::ranges::greater{}, &timer_entry::deadline);
+        }
+
+        void cancel_timer(details::async_operation &operation) noexcept {
+            if (operation.timer == details::no_timer) return;
+            auto &slot = timer_slots[operation.timer];
+            slot.operation = nullptr;
+            ++slot.generation;
+            free_slots.push_back(operation.timer);
+            operation.timer = details::no_timer;
+        }
+
+        void complete(details::async_operation &operation) noexcept {
+            cancel_timer(operation);
+            operation.waiting = nullptr;
+            ready.push_back(operation.handle);
+        }
+
+        void dispatch(details::fd_state &state, const std::uint32_t flags) noexcept {
+            constexpr std::uint32_t failure = EPOLLERR | EPOLLHUP;
+            if (state.reader != nullptr && (flags & (EPOLLIN | failure)) && state.reader->attempt(*state.reader))
+                complete(*std::exchange(state.reader, nullptr));
+            if (state.writer != nullptr && (flags & (EPOLLOUT | failure)) && state.writer->attempt(*state.writer))
+                complete(*std::exchange(state.writer, nullptr));
+            if (state.reader != nullptr || state.writer != nullptr) arm(state);
+        }
+
+        void expire_timers() noexcept {
+            const auto now = clock_type::now();
+            while (!timers.empty() && timers.front().deadline <= now) {
+                std::ranges::pop_heap(timers, std::ranges::greater{}, &timer_entry::deadline);
+                const auto entry = timers.back();
+                timers.pop_back();
+                auto &slot = timer_slots[entry.slot];
+                if (slot.generation != entry.generation || slot.operation == nullptr) continue;
+
+                auto &operation = *slot.operation;
+                if (const auto state = operation.waiting) {
+                    (operation.is_writer ? state->writer : state->reader) = nullptr;
+                    if (state->reader != nullptr || state->writer != nullptr) arm(*state);
+                }
+                complete(operation);
+            }
+        }
+
+        [[nodiscard]] int wait_milliseconds(const std::chrono::milliseconds timeout) const noexcept {
+            if (!ready.empty()) return 0;
+            auto wait = timeout.count() < 0 ? std::numeric_limits<int>::max() : static_cast<int>(timeout.count());
+            if (!timers.empty()) {
+                // 向上取整，避免在截止时刻之前醒来后空转
+                const auto left = std::chrono::ceil<std::chrono::milliseconds>(timers.front().deadline - clock_type::now());
+                wait = std::min(wait, static_cast<int>(std::max<std::int64_t>(left.count(), 0)));
+            }
+            return wait == std::numeric_limits<int>::max() ? -1 : wait;
+        }
+
+        /// @brief 挂起等待 fd 就绪，就绪后由 @c dispatch 再次尝试，供各等待对象使用
+        /// @return 成功挂起时返回 true ，已经就绪或无法注册时返回 false ，此时等待者立即恢复
+        bool suspend(details::async_operation &operation, const int fd, const bool is_writer,
+            const std::chrono::milliseconds timeout) {
+            auto &state = state_of(fd);
+            auto &slot = is_writer ? state.writer : state.reader;
+            if (slot != nullptr) return false;
+            slot = &operation;
+            operation.waiting = &state;
+            operation.is_writer = is_writer;
+            arm(state);
+            if (timeout.count() >= 0) start_timer(operation, timeout);
+            return true;
+        }
+
+        /// @brief 只由定时器恢复的操作
+        void suspend(details::async_operation &operation, const std::chrono::milliseconds timeout) {
+            start_timer(operation, timeout);
+        }
+
+    public:
+        /// @exception std::system_error 无法创建 epoll 或 eventfd 时抛出异常
+        coroutine_executor() {
+            epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (epoll_fd < 0) details::throw_errno("epoll_create1");
+            stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (stop_fd < 0) {
+                ::close(epoll_fd);
+                details::throw_errno("eventfd");
+            }
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = nullptr;
+            ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event);
+            events.resize(64);
+        }
+
+        coroutine_executor(const coroutine_executor &) = delete;
+        coroutine_executor &operator=(const coroutine_executor &) = delete;
+
+        /// @note 仍未结束的会话不会被恢复，其协程帧随之泄漏，应在所有会话结束后再销毁执行器
+        ~coroutine_executor() {
+            ::close(stop_fd);
+            ::close(epoll_fd);
+        }
+
+        /// @brief 分离运行顶层任务，任务结束时自行销毁
+        void spawn(async_task<> task) {
+            const auto handle = task.release();
+            handle.promise().set_detached(&live_count);
+            ++live_count;
+            ready.push_back(handle);
+        }
+
+        /// @brief 将 fd 移出 epoll ，应在关闭 fd 之前、且没有协程等待它时调用
+        void forget(const int fd) noexcept {
+            if (fds.erase(fd) != 0) ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+
+        /// @brief 尚未结束的顶层任务数量
+        [[nodiscard]] size_type task_count() const noexcept { return live_count; }
+
+        /// @brief 等待并处理一轮 fd 事件与定时器，然后恢复所有就绪的协程，已有就绪的协程时不等待
+        /// @return 本轮恢复的协程数量
+        size_type poll_once(const std::chrono::milliseconds timeout) noexcept {
+            int count;
+            do count = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), wait_milliseconds(timeout));
+            while (count < 0 && errno == EINTR);
+            for (int i = 0; i < count; ++i) {
+                const auto state = static_cast<details::fd_state *>(events[i].data.ptr);
+                if (state == nullptr) {
+                    std::uint64_t value;
+                    (void)!::read(stop_fd, &value, sizeof(value));
+                    continue;
+                }
+                dispatch(*state, events[i].events);
+            }
+            expire_timers();
+
+            // 恢复期间新就绪的协程留到下一轮，避免互相唤醒的协程饿死 fd 事件
+            running.swap(ready);
+            for (const auto handle : running) handle.resume();
+            const auto resumed = running.size();
+            running.clear();
+            return resumed;
+        }
+
+        /// @brief 在当前线程运行，直到 @c stop 被调用或所有顶层任务都已结束
+        void run() noexcept {
+            while (!stopping.load(std::memory_order_acquire) && (live_count != 0 || !ready.empty()))
+                poll_once(std::chrono::milliseconds{-1});
+            stopping.store(false, std::memory_order_release);
+        }
+
+        void operator()() noexcept { run(); }
+
+        /// @brief 请求停止 @c run ，可以在任意线程调用
+        void stop() noexcept {
+            stopping.store(true, std::memory_order_release);
+            const std::uint64_t value{1};
+            (void)!::write(stop_fd, &value, sizeof(value));
+        }
+
+        /// @brief 让出执行权，在下一轮恢复
+        [[nodiscard]] auto yield() noexcept {
+            struct awaiter {
+                coroutine_executor &executor;
+
+                [[nodiscard]] bool await_ready() const noexcept { return false; }
+                void await_suspend(const std::coroutine_handle<> handle) const { executor.ready.push_back(handle); }
+                void await_resume() const noexcept {}
+            };
+            return awaiter{*this};
+        }
+
+        /// @brief 挂起 duration 后恢复
+        [[nodiscard]] auto sleep_for(const std::chrono::milliseconds duration) noexcept {
+            struct awaiter : details::async_operation {
+                coroutine_executor &executor;
+                std::chrono::milliseconds duration;
+
+                awaiter(coroutine_executor &executor, const std::chrono::milliseconds duration) noexcept :
+                    executor(executor), duration(duration) {}
+
+                [[nodiscard]] bool await_ready() const noexcept { return duration.count() <= 0; }
+
+                void await_suspend(const std::coroutine_handle<> handle) {
+                    this->handle = handle;
+                    executor.suspend(*this, duration);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return awaiter{*this, duration};
+        }
+
+        /// @brief 从非阻塞 fd 读取，至少读到 required 字节或 fd 结束、出错、超时时恢复
+        /// @param target fd 或提供 native_handle 的对象，例如 @c fd_rwer 、@c serial_port
+        /// @param required 为 0 时读满 buffer ，默认读到任意字节即返回
+        /// @param timeout 小于 0 表示不超时
+        /// @return co_await 的结果为读取的字节数
+        [[nodiscard]] auto read(const auto &target, const byte_span buffer, const size_type required = 1,
+            const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1}) noexcept {
+            struct awaiter : details::async_operation {
+                coroutine_executor &executor;
+                int fd;
+                byte_span buffer;
+                size_type required;
+                std::chrono::milliseconds timeout;
+                size_type done{0};
+
+                awaiter(coroutine_executor &executor, const int fd, const byte_span buffer, const size_type required,
+                    const std::chrono::milliseconds timeout) noexcept :
+                    executor(executor), fd(fd), buffer(buffer),
+                    required(std::min(required == 0 ? buffer.size() : required, buffer.size())), timeout(timeout) {
+                    attempt = [](details::async_operation &operation) noexcept {
+                        return static_cast<awaiter &>(operation).try_read();
+                    };
+                }
+
+                bool try_read() noexcept {
+                    while (done < required) {
+                        const auto result = ::read(fd, buffer.data() + done, buffer.size() - done);
+                        if (result > 0) done += static_cast<size_type>(result);
+                        else if (result < 0 && errno == EINTR) continue;
+                        else return !(result < 0 && errno == EAGAIN);
+                    }
+                    return true;
+                }
+
+                [[nodiscard]] bool await_ready() noexcept { return try_read(); }
+
+                bool await_suspend(const std::coroutine_handle<> handle) {
+                    this->handle = handle;
+                    return executor.suspend(*this, fd, false, timeout);
+                }
+
+                [[nodiscard]] size_type await_resume() const noexcept { return done; }
+            };
+            return awaiter{*this, details::native_fd(target), buffer, required, timeout};
+        }
+
+        /// @brief 向非阻塞 fd 写入全部字节，写完、出错或超时时恢复
+        /// @return co_await 的结果为写入的字节数
+        [[nodiscard]] auto write(const auto &target, const const_byte_span buffer,
+            const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1}) noexcept {
+            struct awaiter : details::async_operation {
+                coroutine_executor &executor;
+                int fd;
+                const_byte_span buffer;
+                std::chrono::milliseconds timeout;
+                size_type done{0};
+
+                awaiter(coroutine_executor &executor, const int fd, const const_byte_span buffer,
+                    const std::chrono::milliseconds timeout) noexcept :
+                    executor(executor), fd(fd), buffer(buffer), timeout(timeout) {
+                    attempt = [](details::async_operation &operation) noexcept {
+                        return static_cast<awaiter &>(operation).try_write();
+                    };
+                }
+
+                bool try_write() noexcept {
+                    while (done < buffer.size()) {
+                        const auto result = ::write(fd, buffer.data() + done, buffer.size() - done);
+                        if (result > 0) done += static_cast<size_type>(result);
+                        else if (result < 0 && errno == EINTR) continue;
+                        else return !(result < 0 && errno == EAGAIN);
+                    }
+                    return true;
+                }
+
+                [[nodiscard]] bool await_ready() noexcept { return try_write(); }
+
+                bool await_suspend(const std::coroutine_handle<> handle) {
+                    this->handle = handle;
+                    return executor.suspend(*this, fd, true, timeout);
+                }
+
+                [[nodiscard]] size_type await_resume() const noexcept { return done; }
+            };
+            return awaiter{*this, details::native_fd(target), buffer, timeout};
+        }
+
+        /// @brief 从包裹来源取出一个包裹，来源为空时挂起，直到生产者经 @c notifying_sink 通知或超时
+        /// @return co_await 的结果表示是否取到
+        template<typename source_type>
+            requires is_item_source<source_type>
+        [[nodiscard]] auto get(source_type &source, event_notifier &notifier, typename source_type::item_type &item,
+            const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1}) noexcept {
+            struct awaiter : details::async_operation {
+                coroutine_executor &executor;
+                source_type &source;
+                event_notifier &notifier;
+                typename source_type::item_type &item;
+                std::chrono::milliseconds timeout;
+                bool done{false};
+
+                awaiter(coroutine_executor &executor, source_type &source, event_notifier &notifier,
+                    typename source_type::item_type &item, const std::chrono::milliseconds timeout) noexcept :
+                    executor(executor), source(source), notifier(notifier), item(item), timeout(timeout) {
+                    attempt = [](details::async_operation &operation) noexcept {
+                        auto &self = static_cast<awaiter &>(operation);
+                        self.notifier.reset();
+                        return self.done = self.source.get(self.item);
+                    };
+                }
+
+                [[nodiscard]] bool await_ready() noexcept { return done = source.get(item); }
+
+                bool await_suspend(const std::coroutine_handle<> handle) {
+                    this->handle = handle;
+                    // 先清除通知再检查一次，之后的投递一定会再次唤醒
+                    if (attempt(*this)) return false;
+                    return executor.suspend(*this, notifier.native_handle(), false, timeout);
+                }
+
+                [[nodiscard]] bool await_resume() const noexcept { return done; }
+            };
+            return awaiter{*this, source, notifier, item, timeout};
+        }
+
+        /// @brief 向包裹接收器投递一个包裹，接收器已满时挂起，直到消费者经 @c notifying_source 通知或超时
+        /// @return co_await 的结果表示是否投递成功
+        template<typename sink_type>
+            requires is_item_sink<sink_type>
+        [[nodiscard]] auto set(sink_type &sink, event_notifier &notifier, const typename sink_type::item_type &item,
+            const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1}) noexcept {
+            struct awaiter : details::async_operation {
+                coroutine_executor &executor;
+                sink_type &sink;
+                event_notifier &notifier;
+                const typename sink_type::item_type &item;
+                std::chrono::milliseconds timeout;
+                bool done{false};
+
+                awaiter(coroutine_executor &executor, sink_type &sink, event_notifier &notifier,
+                    const typename sink_type::item_type &item, const std::chrono::milliseconds timeout) noexcept :
+                    executor(executor), sink(sink), notifier(notifier), item(item), timeout(timeout) {
+                    attempt = [](details::async_operation &operation) noexcept {
+                        auto &self = static_cast<awaiter &>(operation);
+                        self.notifier.reset();
+                        return self.done = self.sink.set(self.item);
+                    };
+                }
+
+                [[nodiscard]] bool await_ready() noexcept { return done = sink.set(item); }
+
+                bool await_suspend(const std::coroutine_handle<> handle) {
+                    this->handle = handle;
+                    if (attempt(*this)) return false;
+                    return executor.suspend(*this, notifier.native_handle(), false, timeout);
+                }
+
+                [[nodiscard]] bool await_resume() const noexcept { return done; }
+            };
+            return awaiter{*this, sink, notifier, item, timeout};
+        }
+    };
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/basic_tasks.hpp>
+
+#include "fd_rwer.hpp"
+
+namespace ly::communicating::posix {
+    /// @brief 基于 eventfd 的唤醒器，来源写入数据后通知事件循环运行对应的写入任务
+    /// @details 事件循环清除标志后才开始排空来源，因此已经有未处理的通知时，再次通知不会产生系统调用
+    class event_notifier {
+        int fd{-1};
+        std::atomic<bool> pending{false};
+
+    public:
+        /// @exception std::system_error 无法创建 eventfd 时抛出异常
+        event_notifier() {
+            fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fd < 0) details::throw_errno("eventfd");
+        }
+
+        event_notifier(const event_notifier &) = delete;
+        event_notifier &operator=(const event_notifier &) = delete;
+
+        ~event_notifier() { ::close(fd); }
+
+        [[nodiscard]] int native_handle() const noexcept { return fd; }
+
+        /// @brief 通知事件循环，可以在任意线程调用
+        void notify() noexcept {
+            if (pending.exchange(true, std::memory_order_acq_rel)) return;
+            const std::uint64_t value{1};
+            (void)!::write(fd, &value, sizeof(value));
+        }
+
+        /// @brief 由事件循环在排空来源之前调用，之后的通知都会再次唤醒事件循环
+        void reset() noexcept {
+            std::uint64_t value;
+            (void)!::read(fd, &value, sizeof(value));
+            pending.exchange(false, std::memory_order_acq_rel);
+        }
+    };
+
+    /// @brief 投递成功后通知事件循环的包裹接收器，用于连接生产者与事件循环中的写入任务
+    template<typename sink_type>
+        requires is_item_sink<sink_type>
+    class notifying_sink {
+        std::shared_ptr<sink_type> sink;
+        std::shared_ptr<event_notifier> notifier;
+
+    public:
+        using item_type = typename sink_type::item_type;
+
+        notifying_sink(std::shared_ptr<sink_type> sink, std::shared_ptr<event_notifier> notifier) :
+            sink(std::move(sink)), notifier(std::move(notifier)) {}
+
+        bool set(const item_type &item) noexcept {
+            if (!sink->set(item)) return false;
+            notifier->notify();
+            return true;
+        }
+    };
+
+    template<typename object_type>
+    concept is_loop_task = requires(object_type &object) {
+        { object.run_once() } -> std::same_as<int>;
+    };
+
+    /// @brief 可以交给事件循环等待的读写器，例如 @c fd_rwer 、@c serial_port
+    /// @details 事件循环把读取超时设为 0 ，由 epoll 负责等待；读写器关闭后 fd 会一直可读，事件循环据此注销任务
+    template<typename object_type>
+    concept is_loop_reader = requires(object_type &object, const std::chrono::milliseconds timeout) {
+        { object.native_handle() } -> std::convertible_to<int>;
+        object.set_read_timeout(timeout);
+        { object.is_closed() } -> std::same_as<bool>;
+    };
+
+    /// @brief 单线程事件循环，在一个线程中驱动多个读取任务与写入任务
+    /// @details
+    ///		读取任务注册在其 fd 上，只有 fd 可读时才调用 run_once；写入任务注册在 @c event_notifier 上，
+    ///		只有来源被通知有数据时才调用 run_once。每次唤醒后连续调用 run_once 直到返回非 0（没有更多数据），
+    ///		最多 max_burst 次，用完次数仍有数据的任务留到下一轮继续处理，避免单个通道独占事件循环。
+    ///		每次的结果都交给监视器，监视器返回 false 时注销该任务。
+    /// @note 注册与注销只能在事件循环所在线程或事件循环启动之前进行，@c stop 可以在任意线程调用。
+    ///		监视器不应在失败时休眠，在事件循环中，读取失败与来源失败只表示暂时没有数据。
+    class event_loop {
+        class registration {
+        public:
+            int fd{-1};
+            bool removed{false};
+            bool queued{false};
+
+            virtual ~registration() = default;
+
+            /// @return 用完 max_burst 次后仍可能有数据时返回 true
+            virtual bool handle(size_type max_burst) noexcept = 0;
+        };
+
+        template<typename task_type, typename monitor_type>
+        class task_registration : public registration {
+        protected:
+            std::shared_ptr<task_type> task;
+            std::shared_ptr<monitor_type> monitor;
+
+        public:
+            task_registration(std::shared_ptr<task_type> task, std::shared_ptr<monitor_type> monitor) :
+                task(std::move(task)), monitor(std::move(monitor)) {}
+
+            bool handle(const size_type max_burst) noexcept override {
+                for (size_type i = 0; i < max_burst; ++i) {
+                    const auto result = task->run_once();
+                    if (!monitor->handle(result)) {
+                        removed = true;
+                        return false;
+                    }
+                    if (result != 0) return false;
+                }
+                return true;
+            }
+        };
+
+        template<typename task_type, typename monitor_type, typename device_type>
+        class device_registration final : public task_registration<task_type, monitor_type> {
+            std::shared_ptr<device_type> device;
+
+        public:
+            device_registration(std::shared_ptr<task_type> task, std::shared_ptr<monitor_type> monitor,
+                std::shared_ptr<device_type> device) :
+                task_registration<task_type, monitor_type>(std::move(task), std::move(monitor)),
+                device(std::move(device)) {
+                this->fd = this->device->native_handle();
+            }
+
+            bool handle(const size_type max_burst) noexcept override {
+                const auto more = task_registration<task_type, monitor_type>::handle(max_burst);
+                if (device->is_closed()) this->removed = true;
+                return more && !this->removed;
+            }
+        };
+
+        template<typename task_type, typename monitor_type>
+        class writer_registration final : public task_registration<task_type, monitor_type> {
+            std::shared_ptr<event_notifier> notifier;
+
+        public:
+            writer_registration(std::shared_ptr<task_type> task, std::shared_ptr<monitor_type> monitor,
+                std::shared_ptr<event_notifier> notifier) :
+                task_registration<task_type, monitor_type>(std::move(task), std::move(monitor)),
+                notifier(std::move(notifier)) {
+                this->fd = this->notifier->native_handle();
+            }
+
+            bool handle(const size_type max_burst) noexcept override {
+                notifier->reset();
+                return task_registration<task_type, monitor_type>::handle(max_burst);
+            }
+        };
+
+        int epoll_fd{-1};
+        int stop_fd{-1};
+        size_type max_burst;
+        std::atomic<bool> stopping{false};
+        bool has_removed{false};
+
+        std::vector<std::unique_ptr<registration>> registrations;
+        /// @brief 上一轮用完 max_burst 次的任务
+        std::vector<registration *> backlog;
+        std::vector<epoll_event> events;
+
+        void add(std::unique_ptr<registration> target) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = target.get();
+            if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, target->fd, &event) != 0) details::throw_errno("epoll_ctl");
+            registrations.push_back(std::move(target));
+            events.resize(registrations.size() + 1);
+        }
+
+        void dispatch(registration *target, std::vector<registration *> &next) noexcept {
+            if (target->removed) return;
+            if (target->handle(max_burst)) {
+                if (!target->queued) {
+                    target->queued = true;
+                    next.push_back(target);
+                }
+            } else if (target->removed) {
+                ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, target->fd, nullptr);
+                has_removed = true;
+            }
+        }
+
+    public:
+        /// @param max_burst 每个任务每轮最多连续调用 run_once 的次数
+        /// @exception std::system_error 无法创建 epoll 或 eventfd 时抛出异常
+        explicit event_loop(const size_type max_burst = 64) : max_burst(std::max<size_type>(max_burst, 1)) {
+            epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (epoll_fd < 0) details::throw_errno("epoll_create1");
+            stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (stop_fd < 0) {
+                ::close(epoll_fd);
+                details::throw_errno("eventfd");
+            }
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = nullptr;
+            ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event);
+            events.resize(1);
+        }
+
+        event_loop(const event_loop &) = delete;
+        event_loop &operator=(const event_loop &) = delete;
+
+        ~event_loop() {
+            ::close(stop_fd);
+            ::close(epoll_fd);
+        }
+
+        /// @brief 注册读取任务，fd 可读时运行
+        /// @details 每次唤醒都会调用 run_once 直到没有数据，最后一次读取必须立即返回，否则会阻塞循环中的所有通道；
+        ///		任务中的读取器因此不能自行等待，@c fd_rwer 与 @c serial_port 应使用下面接受读写器的重载
+        /// @param fd 任务读取的 fd ，应为非阻塞，事件循环不负责关闭
+        /// @exception std::system_error fd 无法加入 epoll 时抛出异常
+        template<is_loop_task task_type, is_result_monitor monitor_type>
+        void add_reader(const int fd, std::shared_ptr<task_type> task, std::shared_ptr<monitor_type> monitor) {
+            auto target = std::make_unique<task_registration<task_type, monitor_type>>(
+                std::move(task), std::move(monitor));
+            target->fd = fd;
+            add(std::move(target));
+        }
+
+        /// @brief 注册读取任务，device 可读时运行，device 是任务读取的读写器
+        /// @details 将 device 的读取超时设为 0 ，等待只发生在 epoll 中；device 关闭（对端断开或串口拔出）后注销任务
+        /// @exception std::system_error fd 无法加入 epoll 时抛出异常
+        template<is_loop_reader device_type, is_loop_task task_type, is_result_monitor monitor_type>
+        void add_reader(std::shared_ptr<device_type> device, std::shared_ptr<task_type> task,
+            std::shared_ptr<monitor_type> monitor) {
+            device->set_read_timeout(std::chrono::milliseconds{0});
+            add(std::make_unique<device_registration<task_type, monitor_type, device_type>>(
+                std::move(task), std::move(monitor), std::move(device)));
+        }
+
+        /// @brief 注册写入任务，通过返回的唤醒器或 @c notifying_sink 通知后运行
+        template<is_loop_task task_type, is_result_monitor monitor_type>
+        [[nodiscard]] std::shared_ptr<event_notifier> add_writer(std::shared_ptr<task_type> task,
+            std::shared_ptr<monitor_type> monitor) {
+            auto notifier = std::make_shared<event_notifier>();
+            add(std::make_unique<writer_registration<task_type, monitor_type>>(
+                std::move(task), std::move(monitor), notifier));
+            return notifier;
+        }
+
+        /// @brief 已注册且未注销的任务数量
+        [[nodiscard]] size_type task_count() const noexcept { return registrations.size(); }
+
+        /// @brief 等待并处理一轮事件，上一轮有未处理完的任务时不等待
+        /// @return 本轮处理的任务数量，超时或被 @c stop 唤醒时可能为 0
+        size_type poll_once(const std::chrono::milliseconds timeout) noexcept {
+            const auto wait = backlog.empty() ? static_cast<int>(timeout.count()) : 0;
+            int count;
+            do count = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), wait);
+            while (count < 0 && errno == EINTR);
+
+            std::vector<registration *> next;
+            auto current = std::exchange(backlog, {});
+            for (const auto target : current) target->queued = false;
+            size_type handled = current.size();
+            for (const auto target : current) dispatch(target, next);
+            for (int i = 0; i < count; ++i) {
+                const auto target = static_cast<registration *>(events[i].data.ptr);
+                if (target == nullptr) {
+                    std::uint64_t value;
+                    (void)!::read(stop_fd, &value, sizeof(value));
+                    continue;
+                }
+                // 已经在上面作为积压任务处理过的不再重复处理
+                if (std::ranges::find(current, target) != current.end()) continue;
+                dispatch(target, next);
+                ++handled;
+            }
+            backlog = std::move(next);
+            if (has_removed) {
+                has_removed = false;
+                std::erase_if(registrations, [](const auto &target) { return target->removed; });
+            }
+            return handled;
+        }
+
+        /// @brief 在当前线程运行事件循环，直到 @c stop 被调用或所有任务都已注销
+        void run() noexcept {
+            while (!stopping.load(std::memory_order_acquire) && !registrations.empty())
+                poll_once(std::chrono::milliseconds{-1});
+            stopping.store(false, std::memory_order_release);
+        }
+
+        void operator()() noexcept { run(); }
+
+        /// @brief 请求停止 @c run ，可以在任意线程调用
+        void stop() noexcept {
+            stopping.store(true, std::memory_order_release);
+            const std::uint64_t value{1};
+            (void)!::write(stop_fd, &value, sizeof(value));
+        }
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/byte_rwer.hpp>
+
+namespace ly::communicating::posix {
+    namespace details {
+        [[noreturn]] inline void throw_errno(const char *what) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        /// @brief 等待 fd 上的事件，返回 revents ，超时或出错时为 0
+        inline short poll_events(const int fd, const short events, const std::chrono::milliseconds timeout) noexcept {
+            pollfd target{fd, events, 0};
+            int result;
+            do result = ::poll(&target, 1, static_cast<int>(timeout.count()));
+            while (result < 0 && errno == EINTR);
+            return result > 0 ? target.revents : 0;
+        }
+
+        /// @brief 等待 fd 可读或可写，超时或出错时返回 false
+        inline bool wait_for(const int fd, const short events, const std::chrono::milliseconds timeout) noexcept {
+            return poll_events(fd, events, timeout) & events;
+        }
+
+        inline void set_nonblock(const int fd) {
+            const auto flags = ::fcntl(fd, F_GETFL);
+            if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) throw_errno("fcntl");
+        }
+
+        /// @brief 从非阻塞 fd 读取当前已到达的字节，没有数据时最多等待 timeout
+        /// @details
+        ///		对端关闭（EOF）、终端挂断（例如 USB 串口被拔出）或出错时立即返回 0 并将 closed 置为 true ，
+        ///		此时 fd 会一直处于就绪状态，不能再交给 poll 等待。
+        ///		VMIN 为 0 的终端没有数据时 read 同样返回 0 ，因此只有 poll 报告就绪之后 read 仍然返回 0 才视为关闭。
+        /// @return 读取的字节数，超时、对端关闭或出错时为 0
+        inline size_type read_some(const int fd, const byte_span buffer, const std::chrono::milliseconds timeout,
+            bool &closed) noexcept {
+            for (auto ready = false;;) {
+                const auto result = ::read(fd, buffer.data(), buffer.size());
+                if (result > 0) return static_cast<size_type>(result);
+                if (result < 0 && errno == EINTR) continue;
+                if ((result < 0 && errno != EAGAIN) || (result == 0 && ready)) {
+                    closed = true;
+                    return 0;
+                }
+                if (result < 0 && timeout.count() == 0) return 0;
+                if (poll_events(fd, POLLIN, timeout) == 0) return 0;
+                ready = true;
+            }
+        }
+
+        /// @brief 向非阻塞 fd 写入所有字节，缓冲区满时最多等待 timeout
+        /// @return 实际写入的字节数
+        inline size_type write_all(const int fd, const const_byte_span buffer, const std::chrono::milliseconds timeout) noexcept {
+            size_type written{0};
+            while (written < buffer.size()) {
+                const auto result = ::write(fd, buffer.data() + written, buffer.size() - written);
+                if (result > 0) {
+                    written += static_cast<size_type>(result);
+                    continue;
+                }
+                if (result < 0 && errno == EINTR) continue;
+                if (result < 0 && errno != EAGAIN) break;
+                if (!wait_for(fd, POLLOUT, timeout)) break;
+            }
+            return written;
+        }
+    }
+
+    /// @brief 任意 fd（管道、套接字、终端）上的非阻塞读写器，持有并负责关闭 fd
+    class fd_rwer final : public byte_rwer {
+        int fd{-1};
+        std::chrono::milliseconds read_timeout;
+        std::chrono::milliseconds write_timeout;
+        bool closed{false};
+
+    public:
+        /// @exception std::system_error 无法设置为非阻塞时抛出异常，此时 fd 仍由调用者负责关闭
+        explicit fd_rwer(const int fd,
+            const std::chrono::milliseconds read_timeout = std::chrono::milliseconds{10},
+            const std::chrono::milliseconds write_timeout = std::chrono::milliseconds{100}) :
+            read_timeout(read_timeout), write_timeout(write_timeout) {
+            details::set_nonblock(fd);
+            this->fd = fd;
+        }
+
+        fd_rwer(const fd_rwer &) = delete;
+        fd_rwer &operator=(const fd_rwer &) = delete;
+
+        ~fd_rwer() override {
+            if (fd >= 0) ::close(fd);
+        }
+
+        [[nodiscard]] int native_handle() const noexcept { return fd; }
+
+        /// @brief 修改没有数据时 read 的最长等待时间，由事件循环驱动时为 0
+        void set_read_timeout(const std::chrono::milliseconds timeout) noexcept { read_timeout = timeout; }
+
+        /// @brief 对端是否已经关闭或读取出错，此后 read 总是立即返回 0 ，应当丢弃读写器并重新连接
+        [[nodiscard]] bool is_closed() const noexcept { return closed; }
+
+        /// @return 读取的字节数，超时时为 0 ；对端关闭或出错时也为 0 且不再等待，通过 @c is_closed 区分
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            return details::read_some(fd, buffer, read_timeout, closed);
+        }
+
+        [[nodiscard]] size_type write(const const_byte_span buffer) override {
+            return details::write_all(fd, buffer, write_timeout);
+        }
+    };
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/basic_bytes.hpp>
+
+namespace ly::communicating::posix {
+    enum class scheduling_policy {
+        /// @brief 不修改调度策略
+        normal,
+        fifo,
+        round_robin,
+        /// @brief SCHED_DEADLINE ，每个周期保证 runtime 的 CPU 时间，要求亲和性覆盖整个根域，通常不能与 cpus 同时使用
+        deadline
+    };
+
+    /// @brief 实时线程的设置，默认值不做任何修改
+    struct realtime_options {
+        /// @brief 绑定的 CPU ，为空且 use_isolated_cpus 为 false 时不修改亲和性
+        std::vector<int> cpus;
+        /// @brief cpus 为空时绑定到内核参数 isolcpus 隔离的 CPU ，没有隔离的 CPU 时不修改亲和性
+        bool use_isolated_cpus{false};
+        scheduling_policy policy{scheduling_policy::normal};
+        /// @brief fifo 与 round_robin 的优先级，1 到 99
+        int priority{50};
+        /// @brief deadline 的参数
+        std::chrono::nanoseconds runtime{std::chrono::microseconds{200}};
+        std::chrono::nanoseconds deadline{std::chrono::milliseconds{1}};
+        std::chrono::nanoseconds period{std::chrono::milliseconds{1}};
+        /// @brief mlockall(MCL_CURRENT | MCL_FUTURE) ，锁定进程的全部内存，避免缺页
+        bool lock_memory{false};
+        /// @brief 启动时预先触碰的栈大小，使任务运行时不再因栈增长缺页
+        size_type prefault_stack{0};
+    };
+
+    /// @brief 实际生效的设置，权限不足或不支持时回退，并在 warnings 中说明
+    struct realtime_report {
+        std::vector<int> cpus;
+        bool scheduling_applied{false};
+        bool memory_locked{false};
+        size_type stack_prefaulted{0};
+        std::vector<std::string> warnings;
+
+        /// @brief 所有请求的设置都已生效
+        [[nodiscard]] bool complete() const noexcept { return warnings.empty(); }
+    };
+
+    namespace details {
+        /// @brief 解析内核的 CPU 列表格式，例如 "2-3,6"
+        [[nodiscard]] inline std::vector<int> parse_cpu_list(const std::string &text) {
+            std::vector<int> cpus;
+            size_type position{0};
+            while (position < text.size()) {
+                auto end = text.find(',', position);
+                if (end == std::string::npos) end = text.size();
+                const auto item = text.substr(position, end - position);
+                const auto dash = item.find('-');
+                try {
+                    const auto first = std::stoi(item.substr(0, dash));
+                    const auto last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+                    for (auto cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+                } catch (const std::exception &) {}
+                position = end + 1;
+            }
+            return cpus;
+        }
+
+        [[nodiscard]] inline std::string errno_text(const int error) {
+            return std::system_category().message(error);
+        }
+
+#if defined(__linux__) && defined(SYS_sched_setattr)
+        /// @brief 与内核 struct sched_attr 布局一致，glibc 2.41 之前没有包装函数
+        struct kernel_sched_attr {
+            std::uint32_t size;
+            std::uint32_t sched_policy;
+            std::uint64_t sched_flags;
+            std::int32_t sched_nice;
+            std::uint32_t sched_priority;
+            std::uint64_t sched_runtime;
+            std::uint64_t sched_deadline;
+            std::uint64_t sched_period;
+        };
+
+        constexpr std::uint32_t kernel_sched_deadline = 6;
+
+        inline int set_deadline(const realtime_options &options) noexcept {
+            kernel_sched_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.sched_policy = kernel_sched_deadline;
+            attributes.sched_runtime = static_cast<std::uint64_t>(options.runtime.count());
+            attributes.sched_deadline = static_cast<std::uint64_t>(options.deadline.count());
+            attributes.sched_period = static_cast<std::uint64_t>(options.period.count());
+            return ::syscall(SYS_sched_setattr, 0, &attributes, 0) == 0 ? 0 : errno;
+        }
+#else
+        inline int set_deadline(const realtime_options &) noexcept { return ENOSYS; }
+#endif
+
+        /// @brief 在当前栈帧之下一次分配连续的 size 字节，从高地址向低地址逐页写入
+        /// @details noinline 保证分配发生在调用者的栈帧之下，返回后这些页面留给任务使用；size 不能超过线程的栈大小
+        [[gnu::noinline]] inline void touch_stack(const size_type size) noexcept {
+            auto *block = static_cast<volatile byte_type *>(::alloca(size));
+            const auto page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+            for (auto offset = size; offset > 0; offset -= std::min(offset, page)) block[offset - 1] = 0;
+            block[0] = 0;
+        }
+    }
+
+    /// @brief 逐页写入缓冲区，使之后的访问不再缺页，配合 lock_memory 使页面常驻内存
+    inline void prefault(const byte_span buffer) noexcept {
+        const auto page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        auto data = reinterpret_cast<volatile byte_type *>(buffer.data());
+        for (size_type i = 0; i < buffer.size(); i += page) data[i] = data[i];
+    }
+
+    /// @brief 内核参数 isolcpus 隔离的 CPU ，读取失败时为空
+    [[nodiscard]] inline std::vector<int> isolated_cpus() {
+        std::ifstream file{"/sys/devices/system/cpu/isolated"};
+        std::string text;
+        std::getline(file, text);
+        return details::parse_cpu_list(text);
+    }
+
+    /// @brief 对当前线程应用实时设置，任何一项失败都不会抛出异常，而是保持原状并记录在报告中
+    inline realtime_report apply_realtime(const realtime_options &options) {
+        realtime_report report;
+
+        auto cpus = options.cpus;
+        if (cpus.empty() && options.use_isolated_cpus) {
+            cpus = isolated_cpus();
+            if (cpus.empty()) report.warnings.emplace_back("no isolated cpus, affinity unchanged");
+        }
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const auto cpu : cpus) CPU_SET(cpu, &set);
+            if (const auto error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set); error == 0)
+                report.cpus = cpus;
+            else report.warnings.push_back("affinity: " + details::errno_text(error));
+        }
+
+        if (options.policy == scheduling_policy::deadline) {
+            if (const auto error = details::set_deadline(options); error == 0) report.scheduling_applied = true;
+            else report.warnings.push_back("SCHED_DEADLINE: " + details::errno_text(error) + ", scheduling unchanged");
+        } else if (options.policy != scheduling_policy::normal) {
+            const auto policy = options.policy == scheduling_policy::fifo ? SCHED_FIFO : SCHED_RR;
+            sched_param parameter{};
+            parameter.sched_priority = std::clamp(options.priority,
+                ::sched_get_priority_min(policy), ::sched_get_priority_max(policy));
+            if (const auto error = ::pthread_setschedparam(::pthread_self(), policy, &parameter); error == 0)
+                report.scheduling_applied = true;
+            else report.warnings.push_back(std::string{policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR"} + ": " +
+                                           details::errno_text(error) + ", scheduling unchanged");
+        }
+
+        if (options.lock_memory) {
+            if (::mlockall(MCL_CURRENT | MCL_FUTURE) == 0) report.memory_locked = true;
+            else report.warnings.push_back("mlockall: " + details::errno_text(errno) + ", memory may page fault");
+        }
+
+        if (options.prefault_stack != 0) {
+            details::touch_stack(options.prefault_stack);
+            report.stack_prefaulted = options.prefault_stack;
+        }
+        return report;
+    }
+
+    /// @brief 以实时设置运行任务的线程，析构时等待任务结束
+    /// @details
+    ///		线程启动后先应用 @c realtime_options ，再调用任务，构造函数在设置应用完成后返回，
+    ///		此时可以通过 @c get_report 检查哪些设置因权限不足或不支持而回退。
+    ///		任务通常是 @c monitored_reader_task::run 这样的循环，由其监视器决定何时退出。
+    /// @code
+    /// realtime_thread thread{{.cpus = {3}, .policy = scheduling_policy::fifo, .priority = 80, .lock_memory = true},
+    ///     [task] { task->run(); }};
+    /// for (const auto &warning : thread.get_report().warnings) std::cerr << warning << '\n';
+    /// @endcode
+    class realtime_thread {
+        realtime_report report;
+        std::thread thread;
+
+    public:
+        /// @exception 应用设置时抛出的异常（例如内存不足）在等待线程结束后重新抛出，此时任务不会运行
+        template<typename task_type>
+        realtime_thread(const realtime_options &options, task_type &&task) {
+            // promise 由线程持有，set_value 之后构造函数即可返回，不会访问已经销毁的同步对象
+            std::promise<void> applied;
+            auto ready = applied.get_future();
+            thread = std::thread{[this, &options, applied = std::move(applied), task = std::forward<task_type>(task)]() mutable {
+                try {
+                    report = apply_realtime(options);
+                } catch (...) {
+                    applied.set_exception(std::current_exception());
+                    return;
+                }
+                applied.set_value();
+                task();
+            }};
+            try {
+                ready.get();
+            } catch (...) {
+                thread.join();
+                throw;
+            }
+        }
+
+        realtime_thread(const realtime_thread &) = delete;
+        realtime_thread &operator=(const realtime_thread &) = delete;
+
+        ~realtime_thread() {
+            if (thread.joinable()) thread.join();
+        }
+
+        [[nodiscard]] const realtime_report &get_report() const noexcept { return report; }
+
+        void join() { thread.join(); }
+
+        [[nodiscard]] std::thread::native_handle_type native_handle() { return thread.native_handle(); }
+    };
+}
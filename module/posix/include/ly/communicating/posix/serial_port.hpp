@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/serial.h>
+#endif
+
+#include <ly/communicating/core/byte_rwer.hpp>
+
+#include "fd_rwer.hpp"
+
+namespace ly::communicating::posix {
+    /// @brief 串口参数
+    struct serial_options {
+        /// @brief 设备路径，例如 /dev/ttyACM0
+        std::string path;
+        /// @brief 波特率，不在标准波特率表中时在 Linux 上通过 BOTHER 设置任意值
+        std::uint32_t baud_rate{115200};
+        /// @brief 尝试开启驱动的 ASYNC_LOW_LATENCY ，不支持时忽略
+        bool low_latency{true};
+        /// @brief read 在没有数据时等待的最长时间，为 0 时立即返回
+        std::chrono::milliseconds read_timeout{10};
+        /// @brief write 在发送缓冲区满时等待的最长时间
+        std::chrono::milliseconds write_timeout{100};
+    };
+
+    namespace details {
+        [[nodiscard]] inline std::optional<speed_t> standard_speed(const std::uint32_t baud_rate) noexcept {
+            switch (baud_rate) {
+                case 9600: return B9600;
+                case 19200: return B19200;
+                case 38400: return B38400;
+                case 57600: return B57600;
+                case 115200: return B115200;
+                case 230400: return B230400;
+#if defined(B460800)
+                case 460800: return B460800;
+                case 921600: return B921600;
+                case 1000000: return B1000000;
+                case 2000000: return B2000000;
+                case 3000000: return B3000000;
+                case 4000000: return B4000000;
+#endif
+                default: return std::nullopt;
+            }
+        }
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__arm__))
+        /// @brief 与内核 struct termios2 布局一致，避免同时包含 <termios.h> 与 <asm/termbits.h> 造成的重定义
+        struct kernel_termios2 {
+            tcflag_t c_iflag;
+            tcflag_t c_oflag;
+            tcflag_t c_cflag;
+            tcflag_t c_lflag;
+            cc_t c_line;
+            cc_t c_cc[19];
+            speed_t c_ispeed;
+            speed_t c_ospeed;
+        };
+
+        constexpr tcflag_t kernel_bother = 0010000;
+        constexpr tcflag_t kernel_cbaud = 0010017;
+
+        /// @brief 通过 BOTHER 设置任意波特率
+        inline bool set_custom_speed(const int fd, const std::uint32_t baud_rate) noexcept {
+            kernel_termios2 options{};
+            if (::ioctl(fd, _IOR('T', 0x2A, kernel_termios2), &options) != 0) return false;
+            options.c_cflag = (options.c_cflag & ~kernel_cbaud) | kernel_bother;
+            options.c_ispeed = baud_rate;
+            options.c_ospeed = baud_rate;
+            return ::ioctl(fd, _IOW('T', 0x2B, kernel_termios2), &options) == 0;
+        }
+#else
+        inline bool set_custom_speed(int, std::uint32_t) noexcept { return false; }
+#endif
+
+        inline bool set_low_latency(const int fd) noexcept {
+#if defined(__linux__) && defined(ASYNC_LOW_LATENCY)
+            serial_struct serial{};
+            if (::ioctl(fd, TIOCGSERIAL, &serial) != 0) return false;
+            serial.flags |= ASYNC_LOW_LATENCY;
+            return ::ioctl(fd, TIOCSSERIAL, &serial) == 0;
+#else
+            (void)fd;
+            return false;
+#endif
+        }
+    }
+
+    /// @brief 基于 termios 的非阻塞串口读写器
+    /// @details
+    ///		以 O_NONBLOCK 打开设备并设置为原始模式，VMIN 与 VTIME 均为 0，由 poll 负责等待，
+    ///		read 返回当前已经到达的所有字节而不是凑满缓冲区，避免 VMIN/VTIME 引入的额外延迟。
+    class serial_port final : public byte_rwer {
+        int fd{-1};
+        std::chrono::milliseconds read_timeout;
+        std::chrono::milliseconds write_timeout;
+        bool low_latency{false};
+        bool closed{false};
+
+        void configure(const serial_options &options) {
+            termios tty{};
+            if (::tcgetattr(fd, &tty) != 0) details::throw_errno("tcgetattr");
+            ::cfmakeraw(&tty);
+            tty.c_cflag |= CLOCAL | CREAD;
+            tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+            tty.c_cc[VMIN] = 0;
+            tty.c_cc[VTIME] = 0;
+
+            const auto speed = details::standard_speed(options.baud_rate);
+            if (speed) ::cfsetspeed(&tty, *speed);
+            if (::tcsetattr(fd, TCSANOW, &tty) != 0) details::throw_errno("tcsetattr");
+            if (!speed && !details::set_custom_speed(fd, options.baud_rate))
+                throw std::system_error(std::make_error_code(std::errc::invalid_argument), "unsupported baud rate");
+
+            if (options.low_latency) low_latency = details::set_low_latency(fd);
+            ::tcflush(fd, TCIOFLUSH);
+        }
+
+        serial_port(const int fd, const serial_options &options) :
+            fd(fd), read_timeout(options.read_timeout), write_timeout(options.write_timeout) {}
+
+    public:
+        /// @brief 打开并配置串口
+        /// @exception std::system_error 打开或配置失败时抛出异常
+        explicit serial_port(const serial_options &options) :
+            read_timeout(options.read_timeout), write_timeout(options.write_timeout) {
+            fd = ::open(options.path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0) details::throw_errno("open");
+            try {
+                configure(options);
+            } catch (...) {
+                ::close(fd);
+                throw;
+            }
+        }
+
+        /// @brief 接管一个已经打开的终端 fd ，例如 openpty 得到的一端，并按 options 配置
+        /// @exception std::system_error 配置失败时抛出异常，此时 fd 仍由调用者负责关闭
+        [[nodiscard]] static std::shared_ptr<serial_port> adopt(const int fd, const serial_options &options) {
+            details::set_nonblock(fd);
+            std::shared_ptr<serial_port> port{new serial_port(fd, options)};
+            try {
+                port->configure(options);
+            } catch (...) {
+                port->fd = -1;
+                throw;
+            }
+            return port;
+        }
+
+        serial_port(const serial_port &) = delete;
+        serial_port &operator=(const serial_port &) = delete;
+
+        ~serial_port() override {
+            if (fd >= 0) ::close(fd);
+        }
+
+        [[nodiscard]] int native_handle() const noexcept { return fd; }
+
+        /// @brief 驱动是否接受了 ASYNC_LOW_LATENCY
+        [[nodiscard]] bool is_low_latency() const noexcept { return low_latency; }
+
+        /// @brief 修改没有数据时 read 的最长等待时间，由事件循环驱动时为 0
+        void set_read_timeout(const std::chrono::milliseconds timeout) noexcept { read_timeout = timeout; }
+
+        /// @brief 对端是否已经挂断或读取出错，例如 USB 串口被拔出，此后应当丢弃串口并重新打开
+        [[nodiscard]] bool is_closed() const noexcept { return closed; }
+
+        /// @brief 读取当前已到达的字节，没有数据时最多等待 read_timeout
+        /// @return 读取的字节数，超时时为 0 ；挂断或出错时也为 0 且不再等待，通过 @c is_closed 区分
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            return details::read_some(fd, buffer, read_timeout, closed);
+        }
+
+        /// @brief 写入所有字节，发送缓冲区满时最多等待 write_timeout
+        /// @return 实际写入的字节数
+        [[nodiscard]] size_type write(const const_byte_span buffer) override {
+            return details::write_all(fd, buffer, write_timeout);
+        }
+
+        /// @brief 等待数据到达，供事件循环或自定义调度使用
+        [[nodiscard]] bool wait_readable(const std::chrono::milliseconds timeout) const noexcept {
+            return details::wait_for(fd, POLLIN, timeout);
+        }
+    };
+
+    /// @brief 按参数打开串口的提供者，打开失败时返回 std::nullopt
+    class serial_port_provider final : public byte_rwer_provider {
+        serial_options options;
+
+    public:
+        explicit serial_port_provider(serial_options options) : options(std::move(options)) {}
+
+        [[nodiscard]] std::optional<std::shared_ptr<rwer_type>> get_rwer() override {
+            try {
+                return std::make_shared<serial_port>(options);
+            } catch (const std::system_error &) {
+                return std::nullopt;
+            }
+        }
+    };
+}
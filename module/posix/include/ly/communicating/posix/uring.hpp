@@ -0,0 +1,518 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if !defined(LY_COMMUNICATING_NO_IO_URING) && defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define LY_COMMUNICATING_IO_URING 1
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#endif
+
+#include <ly/communicating/core/byte_rwer.hpp>
+
+#include "fd_rwer.hpp"
+
+namespace ly::communicating::posix {
+#if LY_COMMUNICATING_IO_URING
+    /// @brief 接收 io_uring 完成事件的对象
+    class uring_handler {
+    public:
+        virtual ~uring_handler() = default;
+
+        /// @param operation 提交时记录的操作编号
+        /// @param result 完成结果，与对应系统调用的返回值相同，错误时为 -errno
+        virtual void complete(std::uint8_t operation, std::int32_t result) noexcept = 0;
+    };
+
+    /// @brief 不依赖 liburing 的 io_uring 封装，持有一组注册到内核的固定缓冲区
+    /// @details
+    ///		提交的请求先留在提交队列中，直到下一次 @c submit 或 @c wait 时随一次 io_uring_enter 一起提交，
+    ///		因此同一个上下文上的多个通道可以共用一次系统调用完成提交与收割。
+    /// @note 上下文及其通道只能在同一个线程中使用，不同线程应各自创建上下文
+    class uring_context final {
+        int ring_fd{-1};
+        io_uring_params params{};
+
+        void *sq_ring{MAP_FAILED};
+        void *cq_ring{MAP_FAILED};
+        size_type sq_ring_size{0};
+        size_type cq_ring_size{0};
+        io_uring_sqe *sqes{static_cast<io_uring_sqe *>(MAP_FAILED)};
+
+        unsigned *sq_head{nullptr};
+        unsigned *sq_tail{nullptr};
+        unsigned *sq_array{nullptr};
+        unsigned sq_mask{0};
+        unsigned *cq_head{nullptr};
+        unsigned *cq_tail{nullptr};
+        io_uring_cqe *cqes{nullptr};
+        unsigned cq_mask{0};
+
+        /// @brief 本地维护的提交队列尾，提交时才发布给内核
+        unsigned local_tail{0};
+        unsigned submitted_tail{0};
+
+        byte_type *buffer_pool{nullptr};
+        size_type buffer_size{0};
+        std::vector<std::uint16_t> free_buffers;
+        bool is_fixed{false};
+
+        size_type syscalls{0};
+        size_type in_flight{0};
+
+        static int enter(const int fd, const unsigned submit, const unsigned wait, const unsigned flags,
+            const void *argument, const size_type argument_size) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submit, wait, flags, argument, argument_size));
+        }
+
+        uring_context() = default;
+
+        bool setup(const unsigned entries, const size_type buffer_count) noexcept {
+            ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (ring_fd < 0) return false;
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+            sq_ring = ::mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) return false;
+            if (params.features & IORING_FEAT_SINGLE_MMAP) cq_ring = sq_ring;
+            else {
+                cq_ring = ::mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd, IORING_OFF_CQ_RING);
+                if (cq_ring == MAP_FAILED) return false;
+            }
+            const auto mapped = ::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+            if (mapped == MAP_FAILED) return false;
+            sqes = static_cast<io_uring_sqe *>(mapped);
+
+            const auto sq = static_cast<byte_type *>(sq_ring);
+            sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+            sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+            sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+            sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+            const auto cq = static_cast<byte_type *>(cq_ring);
+            cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+            cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+            cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+            local_tail = submitted_tail = *sq_tail;
+
+            buffer_pool = static_cast<byte_type *>(std::aligned_alloc(4096, buffer_count * buffer_size));
+            if (buffer_pool == nullptr) return false;
+            std::vector<iovec> vectors(buffer_count);
+            for (size_type i = 0; i < buffer_count; ++i) {
+                vectors[i] = {buffer_pool + i * buffer_size, buffer_size};
+                free_buffers.push_back(static_cast<std::uint16_t>(buffer_count - 1 - i));
+            }
+            // 注册失败（例如 RLIMIT_MEMLOCK 不足）时退化为普通读写请求
+            is_fixed = ::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS,
+                           vectors.data(), static_cast<unsigned>(buffer_count)) == 0;
+            return true;
+        }
+
+        /// @brief 把准备好的请求发布给内核并提交，不收割完成事件
+        /// @details 供 @c next_sqe 在提交队列已满时使用，它可能在 @c reap 分发事件的过程中被调用，不能重入 @c reap
+        void flush_submissions() noexcept {
+            const auto pending = local_tail - submitted_tail;
+            if (pending == 0) return;
+            std::atomic_ref{*sq_tail}.store(local_tail, std::memory_order_release);
+            submitted_tail = local_tail;
+            ++syscalls;
+            enter(ring_fd, pending, 0, 0, nullptr, 0);
+        }
+
+        io_uring_sqe &next_sqe() noexcept {
+            if (local_tail - std::atomic_ref{*sq_head}.load(std::memory_order_acquire) >= params.sq_entries)
+                flush_submissions();
+            const auto index = local_tail & sq_mask;
+            auto &sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sq_array[index] = index;
+            ++local_tail;
+            ++in_flight;
+            return sqe;
+        }
+
+        /// @brief 收割所有已完成的事件，并转交给对应的处理者
+        /// @details 每个事件先取出并推进 cq_head 再分发，处理者在 complete 中提交新请求、甚至再次收割时，
+        ///		都不会重复处理同一个事件
+        size_type reap() noexcept {
+            size_type count{0};
+            while (true) {
+                const auto head = *cq_head;
+                if (head == std::atomic_ref{*cq_tail}.load(std::memory_order_acquire)) return count;
+                const auto &cqe = cqes[head & cq_mask];
+                const auto data = cqe.user_data;
+                const auto result = cqe.res;
+                std::atomic_ref{*cq_head}.store(head + 1, std::memory_order_release);
+                --in_flight;
+                ++count;
+                if (data == 0) continue;
+                reinterpret_cast<uring_handler *>(data & ~std::uint64_t{7})->complete(
+                    static_cast<std::uint8_t>(data & 7), result);
+            }
+        }
+
+    public:
+        /// @brief 创建上下文
+        /// @param entries 提交队列长度
+        /// @param buffer_count 固定缓冲区数量，每个通道占用 3 个（1 个读取，2 个写入）
+        /// @param buffer_size 每个固定缓冲区的大小
+        /// @return 内核不支持或权限不足时返回 nullptr，调用者可以退化为 @c fd_rwer
+        [[nodiscard]] static std::shared_ptr<uring_context> create(const unsigned entries = 64,
+            const size_type buffer_count = 24, const size_type buffer_size = 16384) {
+            std::shared_ptr<uring_context> context{new uring_context};
+            context->buffer_size = buffer_size;
+            if (!context->setup(entries, buffer_count)) return nullptr;
+            return context;
+        }
+
+        uring_context(const uring_context &) = delete;
+        uring_context &operator=(const uring_context &) = delete;
+
+        ~uring_context() {
+            if (sqes != MAP_FAILED) ::munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) ::munmap(cq_ring, cq_ring_size);
+            if (sq_ring != MAP_FAILED) ::munmap(sq_ring, sq_ring_size);
+            if (ring_fd >= 0) ::close(ring_fd);
+            std::free(buffer_pool);
+        }
+
+        /// @brief 缓冲区是否成功注册到内核，此时读写使用 READ_FIXED 与 WRITE_FIXED
+        [[nodiscard]] bool has_fixed_buffers() const noexcept { return is_fixed; }
+
+        /// @brief 已经执行的 io_uring_enter 次数
+        [[nodiscard]] size_type syscall_count() const noexcept { return syscalls; }
+
+        [[nodiscard]] size_type get_buffer_size() const noexcept { return buffer_size; }
+
+        /// @brief 申请一个固定缓冲区，返回其编号，没有空闲缓冲区时返回 -1
+        [[nodiscard]] int acquire_buffer() noexcept {
+            if (free_buffers.empty()) return -1;
+            const auto index = free_buffers.back();
+            free_buffers.pop_back();
+            return index;
+        }
+
+        void release_buffer(const int index) noexcept {
+            free_buffers.push_back(static_cast<std::uint16_t>(index));
+        }
+
+        [[nodiscard]] byte_span buffer(const int index) const noexcept {
+            return {buffer_pool + static_cast<size_type>(index) * buffer_size, buffer_size};
+        }
+
+        /// @brief 在提交队列中准备一个读写请求，队列已满时先提交已有请求
+        void prepare(const std::uint8_t opcode, const int fd, const int buffer_index, const size_type offset,
+            const size_type length, uring_handler *handler, const std::uint8_t operation) noexcept {
+            auto &sqe = next_sqe();
+            const auto fixed = is_fixed && buffer_index >= 0;
+            if (opcode == IORING_OP_READ) sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            else if (opcode == IORING_OP_WRITE) sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            else sqe.opcode = opcode;
+            sqe.fd = fd;
+            sqe.off = static_cast<std::uint64_t>(-1);
+            if (buffer_index >= 0) {
+                sqe.addr = reinterpret_cast<std::uint64_t>(buffer(buffer_index).data() + offset);
+                sqe.len = static_cast<std::uint32_t>(length);
+                if (fixed) sqe.buf_index = static_cast<std::uint16_t>(buffer_index);
+            }
+            sqe.user_data = reinterpret_cast<std::uint64_t>(handler) | operation;
+        }
+
+        /// @brief 取消提交时记录为 handler 与 operation 的请求
+        void prepare_cancel(uring_handler *handler, const std::uint8_t operation) noexcept {
+            auto &sqe = next_sqe();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.fd = -1;
+            sqe.addr = reinterpret_cast<std::uint64_t>(handler) | operation;
+            sqe.user_data = 0;
+        }
+
+        /// @brief 提交所有准备好的请求，不等待完成，并收割已经完成的事件
+        void submit() noexcept {
+            wait(0, std::chrono::nanoseconds{0});
+        }
+
+        /// @brief 提交所有准备好的请求，并最多等待 timeout 直到至少 min_complete 个事件完成，然后收割所有已完成事件
+        /// @return 收割的事件数量
+        size_type wait(const unsigned min_complete, const std::chrono::nanoseconds timeout) noexcept {
+            auto count = reap();
+            const auto pending = local_tail - submitted_tail;
+            const unsigned wait_count = count >= min_complete ? 0 : min_complete;
+            if (pending == 0 && wait_count == 0) return count;
+
+            std::atomic_ref{*sq_tail}.store(local_tail, std::memory_order_release);
+            submitted_tail = local_tail;
+
+            __kernel_timespec time{
+                static_cast<long long>(timeout.count() / 1000000000),
+                static_cast<long long>(timeout.count() % 1000000000)
+            };
+            io_uring_getevents_arg argument{};
+            argument.ts = reinterpret_cast<std::uint64_t>(&time);
+            unsigned flags = wait_count ? IORING_ENTER_GETEVENTS : 0;
+            const void *argument_pointer = nullptr;
+            size_type argument_size = 0;
+            if (wait_count && (params.features & IORING_FEAT_EXT_ARG)) {
+                flags |= IORING_ENTER_EXT_ARG;
+                argument_pointer = &argument;
+                argument_size = sizeof(argument);
+            } else if (wait_count) {
+                // 旧内核不支持等待超时，先提交，再通过 poll 等待完成队列
+                ++syscalls;
+                enter(ring_fd, pending, 0, 0, nullptr, 0);
+                if (!details::wait_for(ring_fd, POLLIN,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(timeout)))
+                    return count;
+                return count + reap();
+            }
+            ++syscalls;
+            enter(ring_fd, pending, wait_count, flags, argument_pointer, argument_size);
+            return count + reap();
+        }
+
+        /// @brief 尚未完成的请求数量
+        [[nodiscard]] size_type pending_count() const noexcept { return in_flight; }
+    };
+
+    /// @brief 基于 io_uring 的读写器
+    /// @details
+    ///		读取：始终保持一个读取请求在途，数据由内核直接写入注册的固定缓冲区，
+    ///		@c read 只从已完成的缓冲区中取出数据，@c peek / @c consume 可以不经拷贝直接解析缓冲区中的数据。
+    ///		写入：@c write 把数据拷贝到固定缓冲区后立即返回，不等待写入完成；
+    ///		上一次写入未完成时，新的数据追加到另一个缓冲区，不产生系统调用，完成后合并为一次提交，保证字节顺序。
+    /// @note 与 @c uring_context 一样只能在同一个线程中使用
+    class uring_channel final : public byte_rwer, uring_handler {
+        enum operation : std::uint8_t {
+            read_operation = 1,
+            write_operation = 2
+        };
+
+        std::shared_ptr<uring_context> context;
+        int fd{-1};
+        std::chrono::nanoseconds read_timeout;
+
+        int read_buffer{-1};
+        bool read_in_flight{false};
+        size_type read_offset{0};
+        size_type read_length{0};
+        std::int32_t last_error{0};
+
+        /// @brief 在途的写入缓冲区与等待提交的写入缓冲区
+        int write_buffers[2]{-1, -1};
+        bool write_in_flight{false};
+        size_type flight_offset{0};
+        size_type flight_length{0};
+        size_type pending_length{0};
+
+        void post_read() noexcept {
+            read_in_flight = true;
+            context->prepare(IORING_OP_READ, fd, read_buffer, 0, context->get_buffer_size(), this, read_operation);
+        }
+
+        void post_write() noexcept {
+            write_in_flight = true;
+            context->prepare(IORING_OP_WRITE, fd, write_buffers[0], flight_offset, flight_length - flight_offset,
+                this, write_operation);
+        }
+
+        void complete(const std::uint8_t operation, const std::int32_t result) noexcept override {
+            if (operation == read_operation) {
+                read_in_flight = false;
+                read_offset = 0;
+                read_length = result > 0 ? static_cast<size_type>(result) : 0;
+                if (result < 0) last_error = -result;
+                return;
+            }
+
+            write_in_flight = false;
+            if (result < 0) {
+                last_error = -result;
+                flight_offset = flight_length;
+            } else
+                flight_offset += static_cast<size_type>(result);
+            if (flight_offset < flight_length) {
+                post_write();
+                return;
+            }
+            // 在途缓冲区写完，交换两个缓冲区，提交等待中的数据
+            std::swap(write_buffers[0], write_buffers[1]);
+            flight_offset = 0;
+            flight_length = std::exchange(pending_length, 0);
+            if (flight_length != 0) post_write();
+        }
+
+        /// @brief 保证有可读数据或读取请求在途，然后最多等待 timeout
+        /// @note timeout 为 0 时不提交请求，留给随后的 @c uring_context::wait 与等待合并为一次系统调用
+        bool fill(const std::chrono::nanoseconds timeout) noexcept {
+            if (read_offset < read_length) return true;
+            if (!read_in_flight) post_read();
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (read_in_flight) {
+                const auto left = deadline - std::chrono::steady_clock::now();
+                if (left <= std::chrono::nanoseconds::zero()) return false;
+                context->wait(1, left);
+            }
+            return read_offset < read_length;
+        }
+
+    public:
+        /// @brief 在上下文上创建通道，持有并负责关闭 fd
+        /// @exception std::runtime_error 上下文中没有足够的固定缓冲区时抛出异常
+        uring_channel(std::shared_ptr<uring_context> context, const int fd,
+            const std::chrono::nanoseconds read_timeout = std::chrono::milliseconds{10}) :
+            context(std::move(context)), fd(fd), read_timeout(read_timeout) {
+            read_buffer = this->context->acquire_buffer();
+            write_buffers[0] = this->context->acquire_buffer();
+            write_buffers[1] = this->context->acquire_buffer();
+            if (read_buffer < 0 || write_buffers[0] < 0 || write_buffers[1] < 0) {
+                release_buffers();
+                throw std::runtime_error("no free io_uring buffer");
+            }
+            // 预先投递读取请求，下一次提交时一并发出
+            post_read();
+        }
+
+        uring_channel(const uring_channel &) = delete;
+        uring_channel &operator=(const uring_channel &) = delete;
+
+        /// @brief 取消在途请求并一直等到它们的完成事件全部收割，之后内核不会再访问缓冲区，也不会再回调本对象
+        /// @details 已经开始执行、无法取消的请求会自行完成，每等待 100 ms 仍未结束就重新取消一次
+        ~uring_channel() override {
+            while (read_in_flight || write_in_flight) {
+                if (read_in_flight) context->prepare_cancel(this, read_operation);
+                if (write_in_flight) context->prepare_cancel(this, write_operation);
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{100};
+                while ((read_in_flight || write_in_flight) && std::chrono::steady_clock::now() < deadline)
+                    context->wait(1, deadline - std::chrono::steady_clock::now());
+            }
+            release_buffers();
+            ::close(fd);
+        }
+
+        [[nodiscard]] int native_handle() const noexcept { return fd; }
+
+        /// @brief 最近一次失败的 errno
+        [[nodiscard]] int error() const noexcept { return last_error; }
+
+        /// @brief 查看已经到达的数据，不拷贝，没有数据时最多等待 timeout
+        /// @details 多个通道共用上下文时，可以对每个通道以 0 超时调用，再通过上下文的 @c wait 统一等待
+        [[nodiscard]] const_byte_span peek(const std::chrono::nanoseconds timeout) noexcept {
+            if (!fill(timeout)) return {};
+            return context->buffer(read_buffer).subspan(read_offset, read_length - read_offset);
+        }
+
+        /// @brief 标记 @c peek 返回的前 bytes 个字节已经处理，全部处理后立即投递下一次读取
+        void consume(const size_type bytes) noexcept {
+            read_offset = std::min(read_offset + bytes, read_length);
+            if (read_offset == read_length && !read_in_flight) post_read();
+        }
+
+        [[nodiscard]] size_type read(const byte_span buffer) override {
+            const auto data = peek(read_timeout);
+            const auto bytes = std::min(data.size(), buffer.size());
+            if (bytes == 0) return 0;
+            std::memcpy(buffer.data(), data.data(), bytes);
+            consume(bytes);
+            return bytes;
+        }
+
+        /// @brief 异步写入，数据拷贝到固定缓冲区后立即返回
+        /// @return 接受的字节数，两个写入缓冲区都满时可能小于 buffer.size()
+        [[nodiscard]] size_type write(const const_byte_span buffer) override {
+            const auto capacity = context->get_buffer_size();
+            size_type accepted{0};
+            while (accepted < buffer.size()) {
+                if (!write_in_flight) {
+                    const auto bytes = std::min(capacity, buffer.size() - accepted);
+                    std::memcpy(context->buffer(write_buffers[0]).data(), buffer.data() + accepted, bytes);
+                    flight_offset = 0;
+                    flight_length = bytes;
+                    post_write();
+                    accepted += bytes;
+                    continue;
+                }
+                if (pending_length < capacity) {
+                    const auto bytes = std::min(capacity - pending_length, buffer.size() - accepted);
+                    std::memcpy(context->buffer(write_buffers[1]).data() + pending_length,
+                        buffer.data() + accepted, bytes);
+                    pending_length += bytes;
+                    accepted += bytes;
+                    continue;
+                }
+                // 两个缓冲区都满，等待在途写入完成
+                if (context->wait(1, std::chrono::milliseconds{100}) == 0 && write_in_flight) break;
+            }
+            context->submit();
+            return accepted;
+        }
+
+        /// @brief 等待所有已接受的数据写完
+        /// @details 追加到等待缓冲区的数据在上一次写入完成并被收割后才会提交，
+        ///		写入方空闲时如果没有其他通道在同一上下文上等待，应调用此函数推进
+        /// @return 超时前全部写完时返回 true
+        bool flush(const std::chrono::nanoseconds timeout = std::chrono::milliseconds{100}) noexcept {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            context->submit();
+            while (write_in_flight) {
+                const auto left = deadline - std::chrono::steady_clock::now();
+                if (left <= std::chrono::nanoseconds::zero()) return false;
+                context->wait(1, left);
+            }
+            return last_error == 0;
+        }
+
+    private:
+        void release_buffers() noexcept {
+            for (const auto index : {read_buffer, write_buffers[0], write_buffers[1]})
+                if (index >= 0) context->release_buffer(index);
+            read_buffer = write_buffers[0] = write_buffers[1] = -1;
+        }
+    };
+#else
+    /// @brief 未启用 io_uring 时的占位上下文，@c create 总是返回 nullptr
+    class uring_context final {
+    public:
+        [[nodiscard]] static std::shared_ptr<uring_context> create(unsigned = 64, size_type = 24, size_type = 16384) {
+            return nullptr;
+        }
+
+        [[nodiscard]] bool has_fixed_buffers() const noexcept { return false; }
+        [[nodiscard]] size_type syscall_count() const noexcept { return 0; }
+    };
+#endif
+
+    /// @brief 创建 fd 上的读写器：上下文可用时使用 io_uring，否则退化为 @c fd_rwer
+    /// @param context 可以为 nullptr
+    [[nodiscard]] inline std::shared_ptr<byte_rwer> make_uring_rwer(
+        [[maybe_unused]] std::shared_ptr<uring_context> context, const int fd,
+        const std::chrono::milliseconds read_timeout = std::chrono::milliseconds{10}) {
+#if LY_COMMUNICATING_IO_URING
+        if (context) {
+            details::set_nonblock(fd);
+            return std::make_shared<uring_channel>(std::move(context), fd, read_timeout);
+        }
+#endif
+        return std::make_shared<fd_rwer>(fd, read_timeout);
+    }
+}
@@ -0,0 +1,5 @@
+#include <ly/communicating/posix.hpp>
+
+int main() {
+
+}
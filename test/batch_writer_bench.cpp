@@ -0,0 +1,99 @@
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include <ly/communicating/core/batch_writer_task.hpp>
+#include <ly/communicating/core/spsc_queue.hpp>
+#include <ly/communicating/core/typed_message.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	using message_type = typed_message<24>;
+	using queue_type = spsc_queue<message_type, 1024>;
+
+	struct copy_unpacker {
+		using item_type = message_type;
+
+		bool unpack(const item_type& item, byte_span buffer) noexcept {
+			std::memcpy(buffer.data(), &item, sizeof(item));
+			return true;
+		}
+	};
+
+	/// @brief 只统计字节数的写入器
+	struct counting_writer {
+		std::size_t bytes{ 0 };
+
+		bool write(byte_span buffer) noexcept {
+			bytes += buffer.size();
+			return true;
+		}
+	};
+
+	std::int64_t thread_cpu_ns() {
+		timespec now{};
+		::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		return now.tv_sec * 1'000'000'000 + now.tv_nsec;
+	}
+
+	/// @brief 生产者每 interval 写入一帧，模拟 1 kHz 量级的控制指令；统计写入次数、平均批次大小与写入线程的 CPU 占用
+	void run(std::chrono::nanoseconds interval, std::chrono::nanoseconds max_delay, std::chrono::nanoseconds poll_interval,
+		std::size_t count) {
+		const auto queue = std::make_shared<queue_type>();
+		const auto writer = std::make_shared<counting_writer>();
+		batch_writer_task<counting_writer, copy_unpacker, queue_type, 16> task{
+			writer, std::make_shared<copy_unpacker>(), queue, max_delay, poll_interval };
+
+		std::atomic<bool> stopping{ false };
+		std::int64_t cpu_ns{ 0 };
+		std::thread consumer{ [&] {
+			const auto begin = thread_cpu_ns();
+			while (true) {
+				if (task.run_once() == 0) continue;
+				if (stopping.load(std::memory_order_acquire) && queue->empty()) break;
+				std::this_thread::sleep_for(100us);
+			}
+			cpu_ns = thread_cpu_ns() - begin;
+		} };
+
+		const auto begin = clock_type::now();
+		auto next = begin;
+		message_type message{};
+		for (std::size_t i = 0; i < count; i++) {
+			next += interval;
+			std::this_thread::sleep_until(next);
+			message.type = static_cast<byte_type>(i);
+			while (!queue->push(message)) std::this_thread::yield();
+		}
+		stopping.store(true, std::memory_order_release);
+		consumer.join();
+		const auto elapsed = to_ns(clock_type::now() - begin);
+
+		std::cout << std::format("interval {:5} us  max_delay {:5} us  poll {:4} us  frames {:6}  writes {:6}  "
+			"frames/write {:5.2f}  writer cpu {:5.1f}%\n",
+			to_ns(interval) / 1000, to_ns(max_delay) / 1000, to_ns(poll_interval) / 1000, task.frame_count(),
+			task.write_count(), task.average_frames_per_write(),
+			100.0 * static_cast<double>(cpu_ns) / static_cast<double>(elapsed));
+	}
+}
+
+int main() {
+	constexpr std::size_t count = 2000;
+	for (const auto interval : { 100us, 1000us }) {
+		run(interval, 0us, 50us, count / (interval / 100us));
+		run(interval, 1ms, 50us, count / (interval / 100us));
+		run(interval, 5ms, 50us, count / (interval / 100us));
+		// 不休眠的对照组，相当于原先的忙等
+		run(interval, 5ms, 0us, count / (interval / 100us));
+	}
+	return 0;
+}
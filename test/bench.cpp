@@ -0,0 +1,958 @@
+﻿#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ly/communicating/core/basic_tasks.hpp>
+#include <ly/communicating/core/byte_reader.hpp>
+#include <ly/communicating/core/cobs.hpp>
+#include <ly/communicating/core/cpu_hint.hpp>
+#include <ly/communicating/core/crc.hpp>
+#include <ly/communicating/core/length_frame_decoder.hpp>
+#include <ly/communicating/core/loopback.hpp>
+#include <ly/communicating/core/message_router.hpp>
+#include <ly/communicating/core/message_schema.hpp>
+#include <ly/communicating/core/mpsc_queue.hpp>
+#include <ly/communicating/core/ping_pong_buffer.hpp>
+#include <ly/communicating/core/ring_decoder.hpp>
+#include <ly/communicating/core/sao_item.hpp>
+#include <ly/communicating/core/seqlock_item.hpp>
+#include <ly/communicating/core/spsc_queue.hpp>
+#include <ly/communicating/core/task_metrics.hpp>
+#include <ly/communicating/core/triple_pool.hpp>
+
+#include "bench_common.hpp"
+
+/// @file
+/// @brief 统一的纳秒级基准测试，结果以 JSON 输出，便于在版本之间比较
+/// @details
+///		用法：ly_communicating_bench [--ops N] [--filter 子串] [--interval 纳秒] [--no-pin] [--out 文件]
+///		- sink_source：生产者线程与消费者线程分别绑定到不同 CPU ，生产者全速或按 --interval 的间隔写入，
+///		  记录写入吞吐、写入到读出的延迟分位数，以及最新值存储被覆盖造成的丢失率
+///		- decoder：单线程解码连续的有效数据包流，记录每帧耗时分位数与吞吐
+///		- verifier：单线程校验数据包，记录每帧耗时分位数与吞吐
+///		- framing：COBS 编码吞吐，以及含大量头字节与损坏帧的噪声数据流上，COBS 与头字节方案的重新同步开销
+///		- loopback：生产者与消费者线程经过 @c make_loopback_pair 收发数据包流，分别在理想通道与切分、位翻转、丢段的噪声通道上
+///		  记录端到端吞吐与丢帧率
+///		- task：单线程运行 read → pack → set 链，对比以 std::shared_ptr 与虚函数组合的 @c reader_task 和按值组合的 @c pipeline
+///		  reader_task/metrics 使用 @c task_metrics 并在运行后核对各阶段、失败与字节计数；
+///		  reader_task/router 以 @c message_router 作为投递位置，按 type 分发到多个接收器并核对分发结果
+///		- schema：单线程在线路格式与内存结构体之间转换，对比 @c message_schema 与 memcpy 紧凑结构体
+namespace {
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	struct config {
+		std::size_t ops{ 200000 };
+		std::string filter;
+		bool pin{ true };
+		/// @brief 生产者两次写入之间的间隔，为 0 时全速写入
+		std::chrono::nanoseconds interval{ 0 };
+	};
+
+	struct result {
+		std::string name;
+		std::string kind;
+		std::size_t payload{ 0 };
+		std::size_t ops{ 0 };
+		double ns_per_op{ 0 };
+		std::int64_t p50{ 0 };
+		std::int64_t p99{ 0 };
+		std::int64_t p999{ 0 };
+		std::int64_t max{ 0 };
+		double loss_rate{ 0 };
+		bool pinned{ false };
+
+		[[nodiscard]] std::string to_json() const {
+			const auto mops = ns_per_op > 0 ? 1e3 / ns_per_op : 0.0;
+			const auto mb_per_s = ns_per_op > 0 ? static_cast<double>(payload) * 1e3 / ns_per_op : 0.0;
+			return std::format(
+				R"({{"name":"{}","kind":"{}","payload_bytes":{},"ops":{},"ns_per_op":{:.2f},"throughput_mops":{:.3f},)"
+				R"("throughput_mb_s":{:.1f},"p50_ns":{},"p99_ns":{},"p999_ns":{},"max_ns":{},"loss_rate":{:.6f},"pinned":{}}})",
+				json_escape(name), kind, payload, ops, ns_per_op, mops, mb_per_s, p50, p99, p999, max, loss_rate,
+				pinned ? "true" : "false");
+		}
+	};
+
+	void fill_percentiles(result& target, std::vector<std::int64_t>& samples) {
+		target.p50 = percentile(samples, 0.5);
+		target.p99 = percentile(samples, 0.99);
+		target.p999 = percentile(samples, 0.999);
+		target.max = samples.empty() ? 0 : samples.back();
+	}
+
+	/// @brief 负载，开头 8 字节为从 1 开始的序号，0 表示尚未写入
+	template<std::size_t size>
+	struct payload {
+		static_assert(size >= 16);
+		std::uint64_t sequence;
+		std::array<std::uint8_t, size - sizeof(std::uint64_t)> padding;
+	};
+
+	template<>
+	struct payload<8> {
+		std::uint64_t sequence;
+	};
+
+	constexpr std::size_t queue_capacity = 1024;
+
+	// ---------- sink_source ----------
+
+	template<std::size_t size, typename factory_type>
+	result run_sink_source(const config& options, std::string name, factory_type&& make) {
+		using item_type = payload<size>;
+		auto target = make();
+		std::vector<std::int64_t> pushed_at(options.ops + 1);
+		std::vector<std::int64_t> latencies;
+		latencies.reserve(options.ops);
+
+		const auto cpu_count = std::thread::hardware_concurrency();
+		const auto pin = options.pin && cpu_count >= 2;
+		std::atomic_bool producer_done{ false };
+		std::atomic_bool consumer_ready{ false };
+		std::atomic_bool pinned{ pin };
+		std::int64_t produce_ns{ 0 };
+
+		std::thread consumer{ [&] {
+			if (pin && !pin_current_thread(1)) pinned = false;
+			consumer_ready = true;
+			item_type item{};
+			std::uint64_t last{ 0 };
+			auto idle_since = clock_type::now();
+			while (last < options.ops) {
+				if (target->get(item) && item.sequence > last) {
+					latencies.push_back(to_ns(clock_type::now().time_since_epoch()) - pushed_at[item.sequence]);
+					last = item.sequence;
+					idle_since = clock_type::now();
+					continue;
+				}
+				// 生产者结束后长时间没有新数据，说明最后的数据丢失
+				if (producer_done && clock_type::now() - idle_since > std::chrono::milliseconds{ 100 }) break;
+				cpu_relax();
+			}
+		} };
+
+		std::thread producer{ [&] {
+			if (pin && !pin_current_thread(0)) pinned = false;
+			while (!consumer_ready) cpu_relax();
+			item_type item{};
+			const auto begin = clock_type::now();
+			auto next = begin;
+			for (std::uint64_t sequence = 1; sequence <= options.ops; sequence++) {
+				if (options.interval.count() != 0) {
+					while (clock_type::now() < next) cpu_relax();
+					next += options.interval;
+				}
+				item.sequence = sequence;
+				pushed_at[sequence] = to_ns(clock_type::now().time_since_epoch());
+				// 队列满时重试，只有最新值存储会丢失数据
+				while (!target->set(item)) cpu_relax();
+			}
+			produce_ns = to_ns(clock_type::now() - begin);
+			producer_done = true;
+		} };
+
+		producer.join();
+		consumer.join();
+
+		result output{ std::move(name), "sink_source", size, options.ops };
+		output.ns_per_op = static_cast<double>(produce_ns) / static_cast<double>(options.ops);
+		output.loss_rate = 1.0 - static_cast<double>(latencies.size()) / static_cast<double>(options.ops);
+		output.pinned = pinned;
+		fill_percentiles(output, latencies);
+		return output;
+	}
+
+	// ---------- decoder / verifier ----------
+
+	constexpr byte_type frame_head = 0xA5;
+
+	/// @brief 基准校验：末字节为前面所有字节之和
+	bool sum8_verify(const const_byte_span frame) {
+		byte_type sum{ 0 };
+		for (const auto byte : frame.first(frame.size() - 1)) sum = static_cast<byte_type>(sum + byte);
+		return frame.back() == sum;
+	}
+
+	void sum8_append(const byte_span frame) {
+		byte_type sum{ 0 };
+		for (const auto byte : frame.first(frame.size() - 1)) sum = static_cast<byte_type>(sum + byte);
+		frame.back() = sum;
+	}
+
+	/// @brief 生成 count 个首尾相接的有效数据包
+	std::vector<byte_type> make_stream(std::size_t frame_size, std::size_t count, auto&& append) {
+		std::vector<byte_type> stream(frame_size * count);
+		for (std::size_t i = 0; i < count; i++) {
+			const auto frame = byte_span{ stream }.subspan(i * frame_size, frame_size);
+			for (std::size_t j = 0; j < frame_size; j++) frame[j] = static_cast<byte_type>(i * 31 + j * 7);
+			frame[0] = frame_head;
+			// 避免负载中出现头字节，使结果只反映正常路径
+			for (auto& byte : frame.subspan(1)) if (byte == frame_head) byte = 0;
+			append(frame);
+		}
+		return stream;
+	}
+
+	/// @brief 以 batch 帧为一组计时，样本为组内平均每帧耗时
+	constexpr std::size_t batch = 64;
+
+	/// @brief 单线程计时：每组 batch 帧调用一次 step(begin, count) ，返回成功处理的帧数
+	result run_single(const config& options, std::string name, std::string kind, std::size_t size, auto&& step) {
+		const auto ops = options.ops - options.ops % batch;
+		std::vector<std::int64_t> samples;
+		samples.reserve(ops / batch);
+		std::size_t processed{ 0 };
+		const auto begin = clock_type::now();
+		for (std::size_t i = 0; i < ops; i += batch) {
+			const auto start = clock_type::now();
+			processed += step(i, batch);
+			samples.push_back(to_ns(clock_type::now() - start) / static_cast<std::int64_t>(batch));
+		}
+		const auto elapsed = to_ns(clock_type::now() - begin);
+
+		result output{ std::move(name), std::move(kind), size, ops };
+		output.ns_per_op = static_cast<double>(elapsed) / static_cast<double>(ops);
+		output.loss_rate = 1.0 - static_cast<double>(processed) / static_cast<double>(ops);
+		fill_percentiles(output, samples);
+		return output;
+	}
+
+	/// @brief 数据流长度，循环使用，避免大负载时占用过多内存
+	constexpr std::size_t stream_frames = 1024;
+
+	template<std::size_t size>
+	result run_ring_decoder(const config& options) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		auto decoder = std::make_unique<ring_frame_decoder<size, sum8_verify>>(frame_head);
+		std::size_t checksum{ 0 };
+		auto output = run_single(options, std::format("ring_frame_decoder/{}B", size), "decoder", size,
+			[&](std::size_t first, std::size_t count) {
+				const auto offset = (first % stream_frames) * size;
+				return decoder->feed(const_byte_span{ stream }.subspan(offset, count * size),
+					[&](const_byte_span frame) { checksum += frame[1]; });
+			});
+		do_not_optimize(checksum);
+		return output;
+	}
+
+	template<std::size_t size>
+	result run_ping_pong(const config& options) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		struct message { byte_array<size> bytes; };
+		auto toolkit = std::make_unique<reader_toolkit<message, sum8_verify>>();
+		toolkit->ping_pong.head = frame_head;
+		auto output = run_single(options, std::format("ping_pong_span/{}B", size), "decoder", size,
+			[&](std::size_t first, std::size_t count) {
+				std::size_t decoded{ 0 };
+				for (std::size_t i = first; i < first + count; i++) {
+					const auto frame = const_byte_span{ stream }.subspan((i % stream_frames) * size, size);
+					std::ranges::copy(frame, toolkit->reader_span.begin());
+					decoded += toolkit->ping_pong.examine(toolkit->result_span());
+				}
+				return decoded;
+			});
+		do_not_optimize(toolkit->result_buffer);
+		return output;
+	}
+
+	/// @brief 裁判系统协议的变长数据包流，整包长度为 size
+	template<std::size_t size>
+	result run_length_decoder(const config& options) {
+		using layout = referee_frame_layout;
+		std::vector<byte_type> stream(size * stream_frames);
+		for (std::size_t i = 0; i < stream_frames; i++) {
+			const auto frame = byte_span{ stream }.subspan(i * size, size);
+			for (std::size_t j = 0; j < size; j++) frame[j] = static_cast<byte_type>(i * 31 + j * 7);
+			frame[3] = static_cast<byte_type>(i);
+			layout::seal(frame);
+		}
+		auto decoder = std::make_unique<length_frame_decoder<layout>>();
+		std::size_t checksum{ 0 };
+		auto output = run_single(options, std::format("length_frame_decoder/{}B", size), "decoder", size,
+			[&](std::size_t first, std::size_t count) {
+				const auto offset = (first % stream_frames) * size;
+				return decoder->feed(const_byte_span{ stream }.subspan(offset, count * size),
+					[&](const auto& view) { checksum += layout::command(view.frame) + view.payload.size(); });
+			});
+		do_not_optimize(checksum);
+		return output;
+	}
+
+	template<std::size_t size>
+	result run_verifier(const config& options, std::string name, byte_verifier verify, auto&& append) {
+		const auto stream = make_stream(size, stream_frames, append);
+		return run_single(options, std::format("{}/{}B", name, size), "verifier", size,
+			[&](std::size_t first, std::size_t count) {
+				std::size_t valid{ 0 };
+				for (std::size_t i = first; i < first + count; i++)
+					valid += verify(const_byte_span{ stream }.subspan((i % stream_frames) * size, size));
+				return valid;
+			});
+	}
+
+	/// @brief 以指定的 update 实现计算 CRC 并与末尾比较，用于对比同一算法的不同实现
+	template<typename crc_type, auto update>
+	bool crc_variant_verify(const const_byte_span frame) {
+		auto value = crc_type::finalize(update(crc_type::initial(), frame.first(frame.size() - crc_type::size)));
+		for (const auto byte : frame.last(crc_type::size)) {
+			if (byte != static_cast<byte_type>(value)) return false;
+			value = static_cast<typename crc_type::value_type>(value >> 8);
+		}
+		return true;
+	}
+
+	// 各预设算法对 "123456789" 的标准检验值，编译期逐字节查表计算
+	constexpr std::array<byte_type, 9> crc_check_input{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	static_assert(crc8_smbus::compute(crc_check_input) == 0xF4);
+	static_assert(crc8_maxim::compute(crc_check_input) == 0xA1);
+	static_assert(crc16_ccitt_false::compute(crc_check_input) == 0x29B1);
+	static_assert(crc16_mcrf4xx::compute(crc_check_input) == 0x6F91);
+	static_assert(crc16_modbus::compute(crc_check_input) == 0x4B37);
+	static_assert(crc32::compute(crc_check_input) == 0xCBF43926);
+	static_assert(crc32c::compute(crc_check_input) == 0xE3069283);
+
+	// ---------- framing ----------
+
+	/// @brief 每隔 corrupt_every 帧损坏一个字节，为 0 时不损坏
+	constexpr std::size_t corrupt_every = 8;
+
+	/// @brief 噪声负载：约四分之一的字节等于头字节，其余随机
+	std::vector<byte_type> make_noisy_payload(std::mt19937& random, std::size_t size) {
+		std::vector<byte_type> payload(size);
+		for (auto& byte : payload) byte = random() % 4 == 0 ? frame_head : static_cast<byte_type>(random());
+		return payload;
+	}
+
+	/// @brief 头字节方案的噪声数据流，校验为 sum8 ，与 @c run_ring_decoder 相同
+	template<std::size_t size>
+	result run_noisy_ring_decoder(const config& options) {
+		std::mt19937 random{ 1 };
+		std::vector<byte_type> stream;
+		for (std::size_t i = 0; i < stream_frames; i++) {
+			auto frame = make_noisy_payload(random, size);
+			frame[0] = frame_head;
+			sum8_append(frame);
+			if (i % corrupt_every == corrupt_every - 1) frame[1 + random() % (size - 1)] ^= 0x5A;
+			stream.insert(stream.end(), frame.begin(), frame.end());
+		}
+		auto decoder = std::make_unique<ring_frame_decoder<size, sum8_verify>>(frame_head);
+		std::size_t checksum{ 0 };
+		auto output = run_single(options, std::format("ring_frame_decoder/noisy/{}B", size), "framing", size,
+			[&](std::size_t first, std::size_t count) {
+				const auto offset = (first % stream_frames) * size;
+				return decoder->feed(const_byte_span{ stream }.subspan(offset, count * size),
+					[&](const_byte_span frame) { checksum += frame[1]; });
+			});
+		do_not_optimize(checksum);
+		return output;
+	}
+
+	/// @brief COBS 数据流，负载末字节为 sum8 ，与头字节方案一样逐帧校验；noisy 时使用噪声负载并损坏部分帧
+	template<std::size_t size, bool noisy>
+	result run_cobs_decoder(const config& options) {
+		std::mt19937 random{ 1 };
+		std::vector<byte_type> stream;
+		// 第 i 帧在 stream 中的起点，最后一项为 stream 的长度
+		std::vector<std::size_t> offsets;
+		std::vector<byte_type> encoded(cobs_max_encoded_size(size));
+		for (std::size_t i = 0; i < stream_frames; i++) {
+			std::vector<byte_type> frame(size);
+			if constexpr (noisy) frame = make_noisy_payload(random, size);
+			else for (std::size_t j = 0; j < size; j++) frame[j] = static_cast<byte_type>(i * 31 + j * 7);
+			sum8_append(frame);
+			auto encoded_size = *cobs_encode(frame, encoded);
+			if (noisy && i % corrupt_every == corrupt_every - 1) encoded[random() % encoded_size] ^= 0x5A;
+			offsets.push_back(stream.size());
+			stream.insert(stream.end(), encoded.begin(), encoded.begin() + encoded_size);
+			stream.push_back(0);
+		}
+		offsets.push_back(stream.size());
+
+		auto decoder = std::make_unique<cobs_stream_decoder<size>>();
+		std::size_t checksum{ 0 };
+		auto output = run_single(options, std::format("cobs_stream_decoder/{}{}B", noisy ? "noisy/" : "", size),
+			noisy ? "framing" : "decoder", size,
+			[&](std::size_t first, std::size_t count) {
+				const auto begin = first % stream_frames;
+				std::size_t valid{ 0 };
+				decoder->feed(const_byte_span{ stream }.subspan(offsets[begin], offsets[begin + count] - offsets[begin]),
+					[&](const_byte_span frame) {
+						if (frame.size() != size || !sum8_verify(frame)) return;
+						checksum += frame[0];
+						++valid;
+					});
+				return valid;
+			});
+		do_not_optimize(checksum);
+		return output;
+	}
+
+	template<std::size_t size>
+	result run_cobs_encode(const config& options) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		std::vector<byte_type> encoded(cobs_max_encoded_size(size));
+		std::size_t checksum{ 0 };
+		auto output = run_single(options, std::format("cobs_encode/{}B", size), "framing", size,
+			[&](std::size_t first, std::size_t count) {
+				for (std::size_t i = first; i < first + count; i++)
+					checksum += *cobs_encode(const_byte_span{ stream }.subspan((i % stream_frames) * size, size), encoded);
+				return count;
+			});
+		do_not_optimize(checksum);
+		return output;
+	}
+
+	// ---------- loopback ----------
+
+	/// @brief 噪声回环：每段 1 到 64 字节，模拟串口驱动每次读到的一小段，并注入位翻转与整段丢弃
+	const loopback_options noisy_loopback{ .min_chunk = 1, .max_chunk = 64, .bit_error_rate = 1e-5, .drop_rate = 1e-3, .seed = 7 };
+
+	/// @brief 生产者线程以 batch 帧为一次写入经过回环读写器，消费者线程读取并交给 @c ring_frame_decoder ，
+	///		记录端到端吞吐、每 batch 帧的平均解码间隔分位数，以及损坏或丢弃造成的丢帧率
+	template<std::size_t size>
+	result run_loopback(const config& options, std::string name, const loopback_options& channel) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		const auto ops = options.ops - options.ops % batch;
+		const auto [source, sink] = make_loopback_pair(channel);
+		auto decoder = std::make_unique<ring_frame_decoder<size, sum8_verify>>(frame_head);
+		std::vector<std::int64_t> samples;
+		samples.reserve(ops / batch + 1);
+
+		const auto pin = options.pin && std::thread::hardware_concurrency() >= 2;
+		std::atomic_bool producer_done{ false };
+		std::atomic_bool consumer_ready{ false };
+		std::atomic_bool pinned{ pin };
+		std::size_t decoded{ 0 };
+		std::int64_t consume_ns{ 0 };
+
+		std::thread consumer{ [&] {
+			if (pin && !pin_current_thread(1)) pinned = false;
+			std::vector<byte_type> buffer(1 << 16);
+			std::size_t checksum{ 0 };
+			consumer_ready = true;
+			const auto begin = clock_type::now();
+			auto last_batch = begin;
+			auto idle_since = begin;
+			while (decoded < ops) {
+				const auto bytes = sink->read(buffer);
+				if (bytes == 0) {
+					// 生产者结束后长时间没有新数据，说明剩余的帧已经丢失
+					if (producer_done && clock_type::now() - idle_since > std::chrono::milliseconds{ 100 }) break;
+					std::this_thread::yield();
+					continue;
+				}
+				const auto before = decoded / batch;
+				decoded += decoder->feed(const_byte_span{ buffer }.first(bytes), [&](const_byte_span frame) { checksum += frame[1]; });
+				idle_since = clock_type::now();
+				if (decoded / batch != before) {
+					samples.push_back(to_ns(idle_since - last_batch) / static_cast<std::int64_t>((decoded / batch - before) * batch));
+					last_batch = idle_since;
+				}
+			}
+			consume_ns = to_ns(clock_type::now() - begin);
+			do_not_optimize(checksum);
+		} };
+
+		std::thread producer{ [&] {
+			if (pin && !pin_current_thread(0)) pinned = false;
+			while (!consumer_ready) cpu_relax();
+			for (std::size_t i = 0; i < ops; i += batch) {
+				auto chunk = const_byte_span{ stream }.subspan((i % stream_frames) * size, batch * size);
+				// 回环满时写入部分字节，让出 CPU 后重试剩余部分，单核机器上也能推进
+				while (!chunk.empty()) {
+					const auto written = source->write(chunk);
+					chunk = chunk.subspan(written);
+					if (written == 0) std::this_thread::yield();
+				}
+			}
+			producer_done = true;
+		} };
+
+		producer.join();
+		consumer.join();
+
+		result output{ std::move(name), "loopback", size, ops };
+		output.ns_per_op = static_cast<double>(consume_ns) / static_cast<double>(ops);
+		output.loss_rate = 1.0 - static_cast<double>(std::min(decoded, ops)) / static_cast<double>(ops);
+		output.pinned = pinned;
+		fill_percentiles(output, samples);
+		return output;
+	}
+
+	// ---------- task ----------
+
+	/// @brief 循环输出内存数据流的读取器，每次读满缓冲区，通过 @c byte_reader 的虚函数调用
+	class stream_reader final : public byte_reader {
+		const_byte_span stream;
+		std::size_t offset{ 0 };
+
+	public:
+		explicit stream_reader(const const_byte_span stream) : stream(stream) {}
+
+		[[nodiscard]] size_type read(const byte_span buffer) override {
+			std::memcpy(buffer.data(), stream.data() + offset, buffer.size());
+			offset += buffer.size();
+			if (offset == stream.size()) offset = 0;
+			return buffer.size();
+		}
+	};
+
+	/// @brief 校验 sum8 后整帧拷贝到负载
+	template<std::size_t size>
+	struct sum8_packer {
+		using item_type = payload<size>;
+
+		bool pack(const const_byte_span buffer, item_type& item) const noexcept {
+			if (!sum8_verify(buffer)) return false;
+			std::memcpy(&item, buffer.data(), sizeof(item));
+			return true;
+		}
+	};
+
+	template<std::size_t size>
+	struct counting_sink {
+		using item_type = payload<size>;
+		std::uint64_t checksum{ 0 };
+
+		bool set(const item_type& item) noexcept {
+			checksum += item.sequence;
+			return true;
+		}
+	};
+
+	/// @brief 同一条 read → pack → set 链，每次 run_once 处理一帧
+	template<std::size_t size>
+	result run_task(const config& options, std::string name, auto& task) {
+		auto output = run_single(options, std::move(name), "task", size, [&](std::size_t, std::size_t count) {
+			std::size_t processed{ 0 };
+			for (std::size_t i = 0; i < count; i++) processed += task.run_once() == 0;
+			return processed;
+		});
+		do_not_optimize(task);
+		return output;
+	}
+
+	/// @brief 现有做法：reader_task 以 std::shared_ptr 持有各阶段，读取器通过基类指针虚调用
+	template<std::size_t size>
+	result run_shared_task(const config& options) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		using reader_type = exact_reader<std::shared_ptr<byte_reader>>;
+		reader_task<reader_type, sum8_packer<size>, counting_sink<size>> task{
+			std::make_shared<reader_type>(std::make_shared<stream_reader>(stream)),
+			std::make_shared<sum8_packer<size>>(),
+			std::make_shared<counting_sink<size>>()
+		};
+		return run_task<size>(options, std::format("reader_task/shared_ptr/{}B", size), task);
+	}
+
+	/// @brief 按值组合：各阶段嵌入流水线内部，读取器按 final 类型调用，整条链可以内联
+	template<std::size_t size>
+	result run_value_pipeline(const config& options) {
+		const auto stream = make_stream(size, stream_frames, sum8_append);
+		auto task = pipeline(exact_reader{ stream_reader{ stream } }, sum8_packer<size>{}, counting_sink<size>{});
+		return run_task<size>(options, std::format("pipeline/value/{}B", size), task);
+	}
+
+	/// @brief 不带度量成员的流水线布局，用于确认 no_metrics 不占用空间
+	template<typename reader_stage, typename packer_stage, typename sink_stage, typename item_type>
+	struct bare_pipeline {
+		[[no_unique_address]] reader_stage reader;
+		[[no_unique_address]] packer_stage packer;
+		[[no_unique_address]] sink_stage sink;
+		[[no_unique_address]] details::task_storage<item_type, true> storage;
+	};
+
+#if !defined(_MSC_VER) || defined(__clang__)
+	static_assert(sizeof(reader_task<exact_reader<std::shared_ptr<byte_reader>>, sum8_packer<64>, counting_sink<64>>)
+		== sizeof(bare_pipeline<std::shared_ptr<exact_reader<std::shared_ptr<byte_reader>>>, std::shared_ptr<sum8_packer<64>>,
+			std::shared_ptr<counting_sink<64>>, payload<64>>));
+	static_assert(sizeof(reader_pipeline<exact_reader<stream_reader>, sum8_packer<64>, counting_sink<64>>)
+		== sizeof(bare_pipeline<exact_reader<stream_reader>, sum8_packer<64>, counting_sink<64>, payload<64>>));
+#endif
+
+	/// @brief reader_task 使用 task_metrics ，每 16 帧有一帧校验和错误；运行后检查度量与实际处理的帧数一致
+	/// @exception std::logic_error 度量与实际结果不一致时抛出异常
+	template<std::size_t size>
+	result run_metrics_task(const config& options) {
+		auto stream = make_stream(size, stream_frames, sum8_append);
+		for (std::size_t i = 15; i < stream_frames; i += 16) stream[i * size + size - 1] ^= 0x01;
+		using reader_type = exact_reader<std::shared_ptr<byte_reader>>;
+		reader_task<reader_type, sum8_packer<size>, counting_sink<size>, task_metrics<>> task{
+			std::make_shared<reader_type>(std::make_shared<stream_reader>(stream)),
+			std::make_shared<sum8_packer<size>>(),
+			std::make_shared<counting_sink<size>>()
+		};
+		auto output = run_task<size>(options, std::format("reader_task/metrics/{}B", size), task);
+
+		const auto snapshot = task.get_metrics().snapshot();
+		const auto failed = snapshot.failure_count(packer_failure);
+		const auto expected_failed = static_cast<std::uint64_t>(std::llround(output.loss_rate * static_cast<double>(output.ops)));
+		if (snapshot.frames + failed != output.ops || failed != expected_failed || snapshot.bytes != snapshot.frames * size
+			|| snapshot.stages[0].total != output.ops || snapshot.stages[1].total != snapshot.frames
+			|| snapshot.stages[2].total != snapshot.frames || snapshot.failure_count(reader_failure) != 0)
+			throw std::logic_error(std::format("{}: metrics mismatch, frames {} failed {} bytes {} stages {}/{}/{}",
+				output.name, snapshot.frames, failed, snapshot.bytes, snapshot.stages[0].total, snapshot.stages[1].total,
+				snapshot.stages[2].total));
+		return output;
+	}
+
+	// ---------- router ----------
+
+	struct gimbal_state {
+		float yaw;
+		float pitch;
+		std::uint16_t mode;
+	};
+
+	struct chassis_state {
+		float vx;
+		float vy;
+		float wz;
+	};
+
+	struct referee_state {
+		std::uint16_t hp;
+		std::uint8_t level;
+	};
+
+	using router_message = typed_message<16>;
+
+	/// @brief 统计收到的数量，并累加数据区的前两个字节（小端），用于核对分发结果
+	template<typename payload_type>
+	struct tally_sink {
+		using item_type = payload_type;
+		std::uint64_t count{ 0 };
+		std::uint64_t checksum{ 0 };
+
+		bool set(const item_type& item) noexcept {
+			std::array<byte_type, 2> first;
+			std::memcpy(first.data(), &item, first.size());
+			++count;
+			checksum += static_cast<std::uint64_t>(first[0] | first[1] << 8);
+			return true;
+		}
+	};
+
+	using gimbal_route = message_route<0x01, gimbal_state, tally_sink<gimbal_state>>;
+	using chassis_route = message_route<0x02, chassis_state, tally_sink<chassis_state>>;
+	using referee_route = message_route<0x07, referee_state, tally_sink<referee_state>>;
+	using router_type = message_router<router_message::DataSize, gimbal_route, chassis_route, referee_route>;
+
+	static_assert(is_item_sink<router_type>);
+	static_assert(router_type::is_routed(0x01) && router_type::is_routed(0x02) && router_type::is_routed(0x07));
+	static_assert(!router_type::is_routed(0x00) && !router_type::is_routed(0x03));
+
+	struct message_packer {
+		using item_type = router_message;
+
+		bool pack(const byte_span buffer, item_type& item) const noexcept {
+			std::memcpy(&item, buffer.data(), sizeof(item));
+			return true;
+		}
+	};
+
+	/// @brief 每 8 帧依次为云台、底盘、云台、裁判、底盘、云台、未注册的 0x03 、底盘
+	constexpr std::array<byte_type, 8> router_types{ 0x01, 0x02, 0x01, 0x07, 0x02, 0x01, 0x03, 0x02 };
+
+	/// @brief reader_task 读取 typed_message 流，message_router 按 type 投递到三个接收器，未注册的类型记为投递失败
+	/// @exception std::logic_error 各接收器收到的数量或内容与数据流不一致、或错误大小的数据没有被拒绝时抛出异常
+	result run_router_task(const config& options) {
+		constexpr auto size = sizeof(router_message);
+		std::vector<byte_type> stream(size * stream_frames);
+		for (std::size_t i = 0; i < stream_frames; i++) {
+			router_message message{ frame_head, router_types[i % router_types.size()], {}, 0x5A };
+			for (std::size_t j = 0; j < message.data.size(); j++) message.data[j] = static_cast<byte_type>(i * 13 + j);
+			std::memcpy(stream.data() + i * size, &message, size);
+		}
+
+		const auto gimbal = std::make_shared<tally_sink<gimbal_state>>();
+		const auto chassis = std::make_shared<tally_sink<chassis_state>>();
+		const auto referee = std::make_shared<tally_sink<referee_state>>();
+		const auto router = std::make_shared<router_type>(gimbal, chassis, referee);
+		using reader_type = exact_reader<std::shared_ptr<byte_reader>>;
+		reader_task<reader_type, message_packer, router_type> task{
+			std::make_shared<reader_type>(std::make_shared<stream_reader>(stream)), std::make_shared<message_packer>(), router
+		};
+		auto output = run_task<size>(options, "reader_task/router", task);
+
+		// 按数据流重新计算每种类型应收到的数量与校验和
+		std::array<std::uint64_t, 256> counts{};
+		std::array<std::uint64_t, 256> checksums{};
+		for (std::size_t i = 0; i < output.ops; i++) {
+			const auto frame = (i % stream_frames) * size;
+			const auto type = stream[frame + offsetof(router_message, type)];
+			const auto data = stream.data() + frame + offsetof(router_message, data);
+			++counts[type];
+			checksums[type] += static_cast<std::uint64_t>(data[0] | data[1] << 8);
+		}
+		const auto dropped = static_cast<std::uint64_t>(std::llround(output.loss_rate * static_cast<double>(output.ops)));
+		if (gimbal->count != counts[0x01] || chassis->count != counts[0x02] || referee->count != counts[0x07]
+			|| dropped != counts[0x03] || gimbal->checksum != checksums[0x01] || chassis->checksum != checksums[0x02]
+			|| referee->checksum != checksums[0x07])
+			throw std::logic_error(std::format("reader_task/router: routed {}/{}/{} dropped {}, expected {}/{}/{} dropped {}",
+				gimbal->count, chassis->count, referee->count, dropped, counts[0x01], counts[0x02], counts[0x07], counts[0x03]));
+
+		// 大小不对的数据：整帧长度不等于 typed_message ，或数据区小于该类型的结构体
+		const const_byte_span first{ stream.data(), size };
+		if (!router->route(first) || router->route(first.first(size - 1))
+			|| router->dispatch(0x02, first.subspan(2, sizeof(chassis_state) - 1)) || router->dispatch(0x03, first.subspan(2, 16)))
+			throw std::logic_error("reader_task/router: a frame of the wrong size or type was accepted");
+		return output;
+	}
+
+	// ---------- schema ----------
+
+	enum class imu_mode : std::uint8_t { idle, calibrating, running, fault };
+
+	/// @brief 自然对齐的内存结构体
+	struct imu_sample {
+		std::uint32_t timestamp;
+		std::int16_t ax, ay, az;
+		float yaw;
+		std::uint16_t sequence;
+		imu_mode mode;
+		bool valid;
+		std::uint8_t channel;
+		std::int16_t temperature;
+	};
+
+	/// @brief 19 字节线路格式：序号为大端，第 16 字节为模式、有效位与通道，温度为 12 位有符号数
+	using imu_schema = message_schema<imu_sample,
+		wire_field<&imu_sample::timestamp, 0>,
+		wire_field<&imu_sample::ax, 4>,
+		wire_field<&imu_sample::ay, 6>,
+		wire_field<&imu_sample::az, 8>,
+		wire_field<&imu_sample::yaw, 10>,
+		wire_field<&imu_sample::sequence, 14, std::endian::big>,
+		wire_field<&imu_sample::mode, 16, std::endian::little, 3, 0>,
+		wire_field<&imu_sample::valid, 16, std::endian::little, 1, 3>,
+		wire_field<&imu_sample::channel, 16, std::endian::little, 4, 4>,
+		wire_field<&imu_sample::temperature, 17, std::endian::little, 12>>;
+
+	static_assert(imu_schema::wire_size == 19);
+	static_assert(is_byte_packer<imu_schema::packer> && is_item_unpacker<imu_schema::unpacker>);
+
+	constexpr imu_sample imu_reference{ 123456789, -1, 2, -300, 1.5f, 0x1234, imu_mode::running, true, 9, -2000 };
+	constexpr auto imu_reference_wire = imu_schema::encode(imu_reference);
+	static_assert(imu_reference_wire[14] == 0x12 && imu_reference_wire[15] == 0x34);
+	static_assert(imu_reference_wire[16] == (2 | 1 << 3 | 9 << 4));
+	static_assert(imu_schema::decode(imu_reference_wire).temperature == -2000);
+	static_assert(imu_schema::decode(imu_reference_wire).yaw == 1.5f);
+	static_assert(imu_schema::decode(imu_reference_wire).mode == imu_mode::running);
+
+	/// @brief 现有做法：按线路格式声明紧凑结构体，memcpy 后逐个成员拷贝到对齐的结构体。
+	///		大端字段与位域需要手写转换，这里只做了整字节部分，开销是对比的下限
+#pragma pack(push, 1)
+	struct imu_packed {
+		std::uint32_t timestamp;
+		std::int16_t ax, ay, az;
+		float yaw;
+		std::uint16_t sequence;
+		std::uint8_t flags;
+		std::int16_t temperature;
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(imu_packed) == imu_schema::wire_size);
+
+	/// @brief 以 batch 个样本为一组，step(wire, item) 转换一个样本
+	result run_schema(const config& options, std::string name, auto&& step) {
+		std::vector<byte_type> wires(imu_schema::wire_size * stream_frames);
+		std::vector<imu_sample> items(stream_frames);
+		for (std::size_t i = 0; i < stream_frames; i++) {
+			auto item = imu_reference;
+			item.timestamp += static_cast<std::uint32_t>(i);
+			item.sequence = static_cast<std::uint16_t>(i);
+			items[i] = item;
+			imu_schema::write(item, byte_span{ wires }.subspan(i * imu_schema::wire_size, imu_schema::wire_size));
+		}
+		auto output = run_single(options, std::move(name), "schema", imu_schema::wire_size,
+			[&](std::size_t first, std::size_t count) {
+				for (std::size_t i = first; i < first + count; i++) {
+					const auto index = i % stream_frames;
+					step(byte_span{ wires }.subspan(index * imu_schema::wire_size, imu_schema::wire_size), items[index]);
+				}
+				return count;
+			});
+		do_not_optimize(wires);
+		do_not_optimize(items);
+		return output;
+	}
+
+	// ---------- registry ----------
+
+	struct bench_case {
+		std::string name;
+		std::function<result(const config&)> run;
+	};
+
+	template<std::size_t size>
+	void add_sink_sources(std::vector<bench_case>& cases) {
+		using item_type = payload<size>;
+		const auto add = [&cases](std::string name, auto make) {
+			name = std::format("{}/{}B", name, size);
+			cases.push_back({ name, [name, make](const config& options) {
+				return run_sink_source<size>(options, name, make);
+			} });
+		};
+		add("shared_atomic_optional_item", [] {
+			return std::make_shared<shared_atomic_optional_item<item_type>>(shared_atomic_optional_item<item_type>::make());
+		});
+		add("nonblock_triple_item_pool", [] { return std::make_shared<cango::utility::nonblock_triple_item_pool<item_type>>(); });
+		add("seqlock_item", [] { return std::make_shared<seqlock_item<item_type>>(); });
+		add("spsc_queue", [] { return std::make_shared<spsc_queue<item_type, queue_capacity>>(); });
+		add("spsc_queue_overwrite", [] {
+			return std::make_shared<spsc_queue<item_type, queue_capacity, queue_full_policy::overwrite>>();
+		});
+		add("mpsc_queue", [] { return std::make_shared<mpsc_queue<item_type, queue_capacity>>(); });
+	}
+
+	template<std::size_t size>
+	void add_decoders(std::vector<bench_case>& cases) {
+		cases.push_back({ std::format("ring_frame_decoder/{}B", size), run_ring_decoder<size> });
+		cases.push_back({ std::format("ping_pong_span/{}B", size), run_ping_pong<size> });
+		if constexpr (size >= referee_frame_layout::overhead && size <= referee_frame_layout::max_frame_size)
+			cases.push_back({ std::format("length_frame_decoder/{}B", size), run_length_decoder<size> });
+	}
+
+	template<std::size_t size>
+	void add_verifiers(std::vector<bench_case>& cases) {
+		cases.push_back({ std::format("sum8/{}B", size), [](const config& options) {
+			return run_verifier<size>(options, "sum8", sum8_verify, sum8_append);
+		} });
+		const auto add = [&cases](std::string name, byte_verifier verify, void (*append)(byte_span)) {
+			cases.push_back({ std::format("{}/{}B", name, size), [name, verify, append](const config& options) {
+				return run_verifier<size>(options, name, verify, append);
+			} });
+		};
+		add("crc8_smbus", crc8_smbus::verify, crc8_smbus::append);
+		add("crc8_maxim", crc8_maxim::verify, crc8_maxim::append);
+		add("crc16_ccitt_false", crc16_ccitt_false::verify, crc16_ccitt_false::append);
+		add("crc16_modbus/bytewise", crc_variant_verify<crc16_modbus, crc16_modbus::update_bytewise>, crc16_modbus::append);
+		add("crc16_modbus/sliced", crc16_modbus::verify, crc16_modbus::append);
+		add("crc32/bytewise", crc_variant_verify<crc32, crc32::update_bytewise>, crc32::append);
+		add("crc32/sliced", crc32::verify, crc32::append);
+		add("crc32c/sliced", crc_variant_verify<crc32c, crc32c::update_sliced>, crc32c::append);
+		add("crc32c/dispatch", crc32c::verify, crc32c::append);
+	}
+
+	template<std::size_t size>
+	void add_framings(std::vector<bench_case>& cases) {
+		cases.push_back({ std::format("cobs_encode/{}B", size), run_cobs_encode<size> });
+		cases.push_back({ std::format("cobs_stream_decoder/{}B", size), run_cobs_decoder<size, false> });
+		cases.push_back({ std::format("ring_frame_decoder/noisy/{}B", size), run_noisy_ring_decoder<size> });
+		cases.push_back({ std::format("cobs_stream_decoder/noisy/{}B", size), run_cobs_decoder<size, true> });
+	}
+
+	template<std::size_t size>
+	void add_loopbacks(std::vector<bench_case>& cases) {
+		cases.push_back({ std::format("loopback/clean/{}B", size), [](const config& options) {
+			return run_loopback<size>(options, std::format("loopback/clean/{}B", size), {});
+		} });
+		cases.push_back({ std::format("loopback/noisy/{}B", size), [](const config& options) {
+			return run_loopback<size>(options, std::format("loopback/noisy/{}B", size), noisy_loopback);
+		} });
+	}
+
+	template<std::size_t size>
+	void add_tasks(std::vector<bench_case>& cases) {
+		cases.push_back({ std::format("reader_task/shared_ptr/{}B", size), run_shared_task<size> });
+		cases.push_back({ std::format("pipeline/value/{}B", size), run_value_pipeline<size> });
+		cases.push_back({ std::format("reader_task/metrics/{}B", size), run_metrics_task<size> });
+	}
+
+	void add_schemas(std::vector<bench_case>& cases) {
+		cases.push_back({ "schema_pack/imu", [](const config& options) {
+			return run_schema(options, "schema_pack/imu", [packer = imu_schema::packer{}](byte_span wire, imu_sample& item) {
+				packer.pack(wire, item);
+			});
+		} });
+		cases.push_back({ "memcpy_pack/imu", [](const config& options) {
+			return run_schema(options, "memcpy_pack/imu", [](byte_span wire, imu_sample& item) {
+				imu_packed packed;
+				std::memcpy(&packed, wire.data(), sizeof(packed));
+				item.timestamp = packed.timestamp;
+				item.ax = packed.ax;
+				item.ay = packed.ay;
+				item.az = packed.az;
+				item.yaw = packed.yaw;
+				item.sequence = packed.sequence;
+				item.mode = static_cast<imu_mode>(packed.flags & 7);
+				item.temperature = packed.temperature;
+			});
+		} });
+		cases.push_back({ "schema_unpack/imu", [](const config& options) {
+			return run_schema(options, "schema_unpack/imu", [unpacker = imu_schema::unpacker{}](byte_span wire, imu_sample& item) {
+				unpacker.unpack(item, wire);
+			});
+		} });
+		cases.push_back({ "memcpy_unpack/imu", [](const config& options) {
+			return run_schema(options, "memcpy_unpack/imu", [](byte_span wire, imu_sample& item) {
+				const imu_packed packed{ item.timestamp, item.ax, item.ay, item.az, item.yaw, item.sequence,
+					static_cast<std::uint8_t>(item.mode), item.temperature };
+				std::memcpy(wire.data(), &packed, sizeof(packed));
+			});
+		} });
+	}
+
+	template<std::size_t... sizes>
+	std::vector<bench_case> make_cases() {
+		std::vector<bench_case> cases;
+		(add_sink_sources<sizes>(cases), ...);
+		(add_decoders<sizes>(cases), ...);
+		(add_verifiers<sizes>(cases), ...);
+		(add_framings<sizes>(cases), ...);
+		(add_loopbacks<sizes>(cases), ...);
+		(add_tasks<sizes>(cases), ...);
+		cases.push_back({ "reader_task/router", run_router_task });
+		add_schemas(cases);
+		return cases;
+	}
+}
+
+int main(int argc, char** argv) {
+	config options;
+	std::string out_path;
+	for (int i = 1; i < argc; i++) {
+		const std::string_view argument{ argv[i] };
+		if (argument == "--ops" && i + 1 < argc) options.ops = std::max<std::size_t>(std::stoull(argv[++i]), batch);
+		else if (argument == "--filter" && i + 1 < argc) options.filter = argv[++i];
+		else if (argument == "--out" && i + 1 < argc) out_path = argv[++i];
+		else if (argument == "--interval" && i + 1 < argc) options.interval = std::chrono::nanoseconds{ std::stoll(argv[++i]) };
+		else if (argument == "--no-pin") options.pin = false;
+		else {
+			std::cerr << "usage: ly_communicating_bench [--ops N] [--filter text] [--interval ns] [--no-pin] [--out file]\n";
+			return 2;
+		}
+	}
+
+	std::vector<std::string> records;
+	for (const auto& target : make_cases<8, 64, 512, 4096>()) {
+		if (!options.filter.empty() && target.name.find(options.filter) == std::string::npos) continue;
+		std::cerr << target.name << std::endl;
+		records.push_back(target.run(options).to_json());
+	}
+
+	std::string json = std::format(R"({{"suite":"ly_communicating_bench","ops":{},"interval_ns":{},"cpus":{},"results":[)",
+		options.ops, options.interval.count(), std::thread::hardware_concurrency());
+	for (std::size_t i = 0; i < records.size(); i++) {
+		if (i != 0) json += ',';
+		json += "\n  " + records[i];
+	}
+	json += "\n]}\n";
+
+	if (out_path.empty()) std::cout << json;
+	else std::ofstream{ out_path } << json;
+	return 0;
+}
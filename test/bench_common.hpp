@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ly::communicating::bench {
+	using clock_type = std::chrono::steady_clock;
+	using time_type = clock_type::time_point;
+
+	inline std::int64_t to_ns(const auto& duration) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	}
+
+	/// @brief 阻止编译器将结果优化掉
+	template<typename T>
+	inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const T* sink;
+		sink = &value;
+#endif
+	}
+
+	/// @brief 重复执行 function 共 iterations 次，返回平均每次耗时（纳秒）
+	inline double ns_per_op(std::size_t iterations, auto&& function) {
+		const auto begin = clock_type::now();
+		for (std::size_t i = 0; i < iterations; i++) function();
+		return static_cast<double>(to_ns(clock_type::now() - begin)) / static_cast<double>(iterations);
+	}
+
+	/// @brief 计算样本的分位数，会对样本排序
+	/// @param ratio 分位，例如 0.99
+	inline std::int64_t percentile(std::vector<std::int64_t>& samples, double ratio) {
+		if (samples.empty()) return 0;
+		std::ranges::sort(samples);
+		const auto index = static_cast<std::size_t>(ratio * static_cast<double>(samples.size() - 1));
+		return samples[index];
+	}
+
+	/// @brief 将当前线程绑定到指定 CPU ，不支持或失败时返回 false
+	inline bool pin_current_thread(std::size_t cpu) {
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	/// @brief 转义 JSON 字符串中的引号、反斜杠与控制字符
+	inline std::string json_escape(std::string_view text) {
+		std::string result;
+		result.reserve(text.size());
+		for (const auto c : text) {
+			if (c == '"' || c == '\\') {
+				result += '\\';
+				result += c;
+			} else if (static_cast<unsigned char>(c) < 0x20)
+				result += ' ';
+			else
+				result += c;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,157 @@
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <ly/communicating/core/ring_decoder.hpp>
+#include <ly/communicating/posix/capture.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	constexpr std::size_t frame_size = 32;
+	constexpr byte_type frame_head = 0xA5;
+
+	bool sum8_verify(const const_byte_span frame) {
+		byte_type sum{ 0 };
+		for (const auto byte : frame.first(frame.size() - 1)) sum = static_cast<byte_type>(sum + byte);
+		return frame.back() == sum;
+	}
+
+	/// @brief 循环输出内存中数据流的读取器，每次最多输出 chunk 字节，模拟串口每次读到的一小段
+	class memory_reader final : public byte_reader {
+		std::vector<byte_type> stream;
+		std::size_t chunk;
+		std::size_t offset{ 0 };
+
+	public:
+		memory_reader(std::vector<byte_type> stream, std::size_t chunk) : stream(std::move(stream)), chunk(chunk) {}
+
+		[[nodiscard]] size_type read(const byte_span buffer) override {
+			const auto bytes = std::min({ buffer.size(), chunk, stream.size() - offset });
+			std::memcpy(buffer.data(), stream.data() + offset, bytes);
+			offset = (offset + bytes) % stream.size();
+			return bytes;
+		}
+	};
+
+	/// @brief 首尾相接的有效数据包流，末字节为 sum8
+	std::vector<byte_type> make_stream(std::size_t count) {
+		std::vector<byte_type> stream(frame_size * count);
+		for (std::size_t i = 0; i < count; i++) {
+			const auto frame = byte_span{ stream }.subspan(i * frame_size, frame_size);
+			byte_type sum{ 0 };
+			for (std::size_t j = 0; j < frame_size - 1; j++) {
+				frame[j] = j == 0 ? frame_head : static_cast<byte_type>(i * 31 + j * 7);
+				if (j != 0 && frame[j] == frame_head) frame[j] = 0;
+				sum = static_cast<byte_type>(sum + frame[j]);
+			}
+			frame.back() = sum;
+		}
+		return stream;
+	}
+
+	/// @brief 热路径开销：同一个读取器直接读取与经过捕获包装读取的每次耗时
+	void capture_overhead(const std::string& path, std::size_t chunk, std::size_t reads) {
+		const auto file = std::make_shared<posix::capture_file>(path, reads * posix::details::capture_record_size(chunk));
+		const auto inner = std::make_shared<memory_reader>(make_stream(4096), chunk);
+		const auto captured = std::make_shared<posix::capture_reader<memory_reader>>(inner, file);
+		std::vector<byte_type> buffer(chunk);
+		std::size_t total{ 0 };
+		const auto plain = ns_per_op(reads, [&] { total += inner->read(buffer); });
+		const auto wrapped = ns_per_op(reads, [&] { total += captured->read(buffer); });
+		do_not_optimize(total);
+		std::cout << std::format("capture {:>4}B reads   plain {:7.1f} ns  captured {:7.1f} ns  (+{:.1f} ns, dropped {})\n",
+			chunk, plain, wrapped, wrapped - plain, file->get_dropped_count());
+	}
+
+	/// @brief 全速回放吞吐：拷贝读取，以及零拷贝地直接交给解码器
+	void replay_throughput(const std::string& path, std::size_t bytes) {
+		constexpr std::size_t chunk = 4096;
+		const auto reads = bytes / chunk;
+		{
+			const auto file = std::make_shared<posix::capture_file>(path, reads * posix::details::capture_record_size(chunk));
+			const auto reader = std::make_shared<posix::capture_reader<memory_reader>>(
+				std::make_shared<memory_reader>(make_stream(chunk / frame_size * 64), chunk), file);
+			std::vector<byte_type> buffer(chunk);
+			for (std::size_t i = 0; i < reads; i++) (void)reader->read(buffer);
+		}
+
+		posix::replay_reader copying{ path };
+		std::vector<byte_type> buffer(1 << 16);
+		std::size_t copied{ 0 };
+		auto begin = clock_type::now();
+		while (const auto size = copying.read(buffer)) copied += size;
+		auto elapsed = to_ns(clock_type::now() - begin);
+		std::cout << std::format("replay read copy        {:8.2f} GB/s ({} MB)\n",
+			static_cast<double>(copied) / static_cast<double>(elapsed), copied >> 20);
+
+		posix::replay_reader direct{ path };
+		auto decoder = std::make_unique<ring_frame_decoder<frame_size, sum8_verify>>(frame_head);
+		std::size_t decoded{ 0 };
+		std::size_t scanned{ 0 };
+		begin = clock_type::now();
+		for (auto span = direct.next_chunk(); !span.empty(); span = direct.next_chunk()) {
+			scanned += span.size();
+			decoded += decoder->feed(span, [](const_byte_span) {});
+		}
+		elapsed = to_ns(clock_type::now() - begin);
+		std::cout << std::format("replay next_chunk+decode{:8.2f} GB/s ({} frames, expected {})\n",
+			static_cast<double>(scanned) / static_cast<double>(elapsed), decoded, scanned / frame_size);
+	}
+
+	/// @brief 定时回放精度：以固定间隔捕获，再按不同倍速回放，比较相邻记录的回放间隔与捕获间隔
+	void replay_timing(const std::string& path, double speed) {
+		constexpr std::size_t records = 500;
+		constexpr auto interval = 200us;
+		std::vector<std::int64_t> captured;
+		{
+			const auto file = std::make_shared<posix::capture_file>(path, records * posix::details::capture_record_size(frame_size));
+			const auto reader = std::make_shared<posix::capture_reader<memory_reader>>(
+				std::make_shared<memory_reader>(make_stream(records), frame_size), file);
+			std::vector<byte_type> buffer(frame_size);
+			auto next = clock_type::now();
+			for (std::size_t i = 0; i < records; i++) {
+				std::this_thread::sleep_until(next);
+				(void)reader->read(buffer);
+				captured.push_back(to_ns(clock_type::now().time_since_epoch()));
+				next += interval;
+			}
+		}
+
+		posix::replay_reader replay{ path, posix::capture_direction::read, speed };
+		std::vector<byte_type> buffer(frame_size);
+		std::vector<std::int64_t> arrivals;
+		const auto begin = clock_type::now();
+		while (!replay.finished())
+			if (replay.read(buffer) > 0) arrivals.push_back(to_ns(clock_type::now() - begin));
+		// 相邻两条记录的回放间隔与捕获间隔除以 speed 之差
+		std::vector<std::int64_t> errors;
+		for (std::size_t i = 1; i < arrivals.size() && i < captured.size(); i++) {
+			const auto expected = static_cast<double>(captured[i] - captured[i - 1]) / speed;
+			errors.push_back(static_cast<std::int64_t>(std::abs(static_cast<double>(arrivals[i] - arrivals[i - 1]) - expected)));
+		}
+		std::cout << std::format("replay x{:<4} {} records  interval error p50 {:7.1f} us  p99 {:7.1f} us\n", speed, arrivals.size(),
+			static_cast<double>(percentile(errors, 0.5)) / 1e3, static_cast<double>(percentile(errors, 0.99)) / 1e3);
+	}
+}
+
+int main() {
+	const auto path = (std::filesystem::temp_directory_path() / "ly_communicating_capture_bench.cap").string();
+	capture_overhead(path, 16, 1 << 20);
+	capture_overhead(path, 64, 1 << 20);
+	capture_overhead(path, 512, 1 << 18);
+	replay_throughput(path, std::size_t{ 256 } << 20);
+	replay_timing(path, 1);
+	replay_timing(path, 4);
+	std::filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,182 @@
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <ly/communicating/core/spsc_queue.hpp>
+#include <ly/communicating/posix/coroutine_executor.hpp>
+
+#include "bench_common.hpp"
+
+/// @brief 统计全局堆分配次数，用于确认稳定运行时每帧数据不分配内存
+/// @details 替换全部普通、数组与 nothrow 形式，分配与释放成对经过 acquire 与 release
+namespace {
+	std::atomic<std::size_t> allocation_count{ 0 };
+
+	void* acquire(std::size_t size) noexcept {
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	[[gnu::noinline]] void release(void* pointer) noexcept { std::free(pointer); }
+}
+
+void* operator new(std::size_t size) {
+	if (auto pointer = acquire(size)) return pointer;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+	if (auto pointer = acquire(size)) return pointer;
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return acquire(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return acquire(size); }
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	constexpr std::size_t frame_size = 16;
+
+	struct conversation_stats {
+		std::size_t completed{ 0 };
+		std::size_t retries{ 0 };
+	};
+
+	/// @brief 发送请求并等待回显的应答，超时后重发，最多 attempts 次
+	async_task<bool> request(posix::coroutine_executor& executor, int fd, std::uint64_t sequence, std::size_t attempts,
+		conversation_stats& stats) {
+		std::array<byte_type, frame_size> frame{};
+		std::array<byte_type, frame_size> ack{};
+		std::memcpy(frame.data(), &sequence, sizeof(sequence));
+		for (std::size_t i = 0; i < attempts; i++) {
+			if (i != 0) ++stats.retries;
+			if (co_await executor.write(fd, frame) != frame.size()) co_return false;
+			// 迟到的应答序号较小，丢弃后继续等待本次的应答
+			while (co_await executor.read(fd, ack, 0, 2ms) == ack.size()) {
+				std::uint64_t echoed;
+				std::memcpy(&echoed, ack.data(), sizeof(echoed));
+				if (echoed == sequence) co_return true;
+			}
+		}
+		co_return false;
+	}
+
+	async_task<> client(posix::coroutine_executor& executor, int fd, std::size_t rounds, conversation_stats& stats) {
+		for (std::uint64_t sequence = 1; sequence <= rounds; sequence++)
+			if (co_await request(executor, fd, sequence, 8, stats)) ++stats.completed;
+		::shutdown(fd, SHUT_WR);
+	}
+
+	/// @brief 回显请求，每 drop_every 个请求故意不应答一次，触发客户端的超时重发
+	async_task<> server(posix::coroutine_executor& executor, int fd, std::size_t drop_every) {
+		std::array<byte_type, frame_size> frame{};
+		for (std::size_t count = 1;; count++) {
+			if (co_await executor.read(fd, frame, 0) != frame.size()) co_return;
+			if (drop_every != 0 && count % drop_every == 0) continue;
+			if (co_await executor.write(fd, frame) != frame.size()) co_return;
+		}
+	}
+
+	/// @brief conversations 对 socketpair 上的请求与应答会话共用一个线程
+	void conversations(std::size_t count, std::size_t rounds, std::size_t drop_every) {
+		posix::coroutine_executor executor;
+		std::vector<int> fds;
+		std::vector<conversation_stats> stats(count);
+		for (std::size_t i = 0; i < count; i++) {
+			int pair[2];
+			if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair) != 0) {
+				std::cerr << "socketpair failed" << std::endl;
+				return;
+			}
+			fds.insert(fds.end(), { pair[0], pair[1] });
+			executor.spawn(client(executor, pair[0], rounds, stats[i]));
+			executor.spawn(server(executor, pair[1], drop_every));
+		}
+
+		// 预热一轮，让对象池、就绪队列与定时器堆达到稳定大小
+		for (int i = 0; i < 64; i++) executor.poll_once(0ms);
+		const auto allocations = allocation_count.load();
+		const auto begin = clock_type::now();
+		executor.run();
+		const auto elapsed = to_ns(clock_type::now() - begin);
+		const auto allocated = allocation_count.load() - allocations;
+
+		conversation_stats total;
+		for (const auto& item : stats) {
+			total.completed += item.completed;
+			total.retries += item.retries;
+		}
+		for (const auto fd : fds) {
+			executor.forget(fd);
+			::close(fd);
+		}
+		std::cout << std::format("{:4} conversations drop 1/{:<4} {:8} round trips {:7.2f} us/round trip {:8.0f} round trips/s"
+			"  retries {:5}  heap allocations {} ({:.4f}/round trip)\n",
+			count, drop_every, total.completed, static_cast<double>(elapsed) / 1e3 / static_cast<double>(total.completed),
+			static_cast<double>(total.completed) * 1e9 / static_cast<double>(elapsed), total.retries, allocated,
+			static_cast<double>(allocated) / static_cast<double>(total.completed));
+	}
+
+	struct sample {
+		std::uint64_t sequence;
+	};
+
+	using queue_type = spsc_queue<sample, 64>;
+
+	/// @brief 同一线程中的生产者与消费者协程经队列交接，队列满或空时挂起在通知器上
+	void handoff(std::size_t count) {
+		posix::coroutine_executor executor;
+		const auto queue = std::make_shared<queue_type>();
+		const auto data_ready = std::make_shared<posix::event_notifier>();
+		const auto space_ready = std::make_shared<posix::event_notifier>();
+		posix::notifying_sink<queue_type> sink{ queue, data_ready };
+		posix::notifying_source<queue_type> source{ queue, space_ready };
+		std::uint64_t received{ 0 };
+
+		executor.spawn([](posix::coroutine_executor& executor, auto& sink, auto& notifier, std::size_t count) -> async_task<> {
+			for (std::uint64_t sequence = 1; sequence <= count; sequence++)
+				if (!co_await executor.set(sink, notifier, sample{ sequence })) co_return;
+		}(executor, sink, *space_ready, count));
+		executor.spawn([](posix::coroutine_executor& executor, auto& source, auto& notifier, std::size_t count,
+			std::uint64_t& received) -> async_task<> {
+			sample item{};
+			while (received < count) {
+				if (!co_await executor.get(source, notifier, item, 100ms)) co_return;
+				if (item.sequence == received + 1) ++received;
+			}
+		}(executor, source, *data_ready, count, received));
+
+		const auto begin = clock_type::now();
+		executor.run();
+		const auto elapsed = to_ns(clock_type::now() - begin);
+		std::cout << std::format("queue handoff {:8} items {:7.1f} ns/item (received {})\n",
+			count, static_cast<double>(elapsed) / static_cast<double>(count), received);
+	}
+}
+
+int main() {
+	conversations(1, 20000, 0);
+	conversations(16, 2000, 0);
+	conversations(256, 200, 0);
+	conversations(256, 200, 97);
+	handoff(1 << 20);
+	return 0;
+}
@@ -0,0 +1,227 @@
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ly/communicating/core/cobs.hpp>
+#include <ly/communicating/core/delta_codec.hpp>
+#include <ly/communicating/core/typed_message.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	constexpr byte_type frame_head = 0xA5;
+	constexpr byte_type frame_tail = 0x5A;
+	constexpr byte_type gimbal_type = 0x01;
+	constexpr byte_type chassis_type = 0x02;
+	/// @brief 115200 波特率 8N1 ，每字节 10 位
+	constexpr double uart_bytes_per_second = 115200.0 / 10.0;
+
+#pragma pack(push, 1)
+	struct gimbal_command {
+		float yaw;
+		float pitch;
+		float yaw_velocity;
+		float pitch_velocity;
+		std::uint8_t mode;
+		std::uint8_t fire;
+		std::uint16_t shoot_count;
+		std::uint16_t bullet_speed;
+		std::uint16_t reserved;
+	};
+
+	struct chassis_command {
+		float vx;
+		float vy;
+		float wz;
+		float power_limit;
+		std::uint8_t mode;
+		std::uint8_t flags;
+		std::uint8_t reserved[6];
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(gimbal_command) == sizeof(chassis_command));
+
+	using message_type = typed_message_wrap<gimbal_command>;
+	constexpr auto data_size = message_type::DataSize;
+
+	static_assert(is_inplace_unpacker<delta_unpacker<data_size>> && is_byte_packer<delta_packer<data_size>>);
+
+	/// @brief 1 kHz 控制周期下交替发送的云台与底盘指令
+	/// @details
+	///		云台跟随运动目标，角度与速度前馈每周期都在变化；开火指令与发射计数偶尔变化。
+	///		底盘速度来自操作手输入，按 50 Hz 更新并在两次输入之间保持不变；功率上限与模式很少变化。
+	///		hold 场景中云台锁定静止目标，只有极小的角度抖动。
+	class command_stream {
+		std::size_t cycle{ 0 };
+		bool tracking;
+		gimbal_command gimbal{};
+		chassis_command chassis{};
+
+	public:
+		explicit command_stream(bool tracking) : tracking(tracking) {
+			gimbal.mode = 2;
+			gimbal.bullet_speed = 2800;
+			chassis.power_limit = 80.0f;
+			chassis.mode = 1;
+		}
+
+		void next(message_type& message) {
+			const auto t = static_cast<double>(cycle) * 1e-3;
+			message.head = frame_head;
+			message.tail = frame_tail;
+			if (cycle % 2 == 0) {
+				if (tracking) {
+					gimbal.yaw = static_cast<float>(0.6 * std::sin(0.7 * t) + 0.05 * std::sin(5.3 * t));
+					gimbal.pitch = static_cast<float>(0.1 * std::sin(1.1 * t));
+					gimbal.yaw_velocity = static_cast<float>(0.42 * std::cos(0.7 * t) + 0.265 * std::cos(5.3 * t));
+					gimbal.pitch_velocity = static_cast<float>(0.11 * std::cos(1.1 * t));
+				} else {
+					// 编码器量化噪声，角度在两个相邻值之间跳动
+					gimbal.yaw = (cycle / 2) % 7 == 0 ? 0.25f : 0.2500001f;
+				}
+				gimbal.fire = (cycle / 200) % 3 == 0;
+				if (gimbal.fire && cycle % 100 == 0) ++gimbal.shoot_count;
+				message.type = gimbal_type;
+				message.data_from(gimbal);
+			} else {
+				if (cycle % 20 == 1) {
+					const auto step = static_cast<double>(cycle / 20);
+					chassis.vx = static_cast<float>(std::round(1.5 * std::sin(0.05 * step) * 100.0) / 100.0);
+					chassis.vy = static_cast<float>(std::round(0.8 * std::cos(0.03 * step) * 100.0) / 100.0);
+					chassis.wz = tracking ? 3.0f : 0.0f;
+				}
+				if (cycle % 5000 == 1) chassis.power_limit = chassis.power_limit == 80.0f ? 100.0f : 80.0f;
+				message.type = chassis_type;
+				message.data_from(chassis);
+			}
+			++cycle;
+		}
+	};
+
+	struct run_result {
+		std::size_t delivered{ 0 };
+		std::size_t mismatched{ 0 };
+		std::size_t wire_bytes{ 0 };
+		std::int64_t unpack_ns{ 0 };
+		std::int64_t pack_ns{ 0 };
+	};
+
+	/// @brief 发送端差分编码，模拟线路每 drop_every 帧丢失一帧，接收端解码后与原消息比较
+	/// @details request_every 不为 0 时，每 request_every 帧调用一次 request_keyframe ，并丢失因此发出的关键帧
+	run_result run_delta(bool tracking, std::size_t count, std::size_t drop_every, std::size_t request_every,
+		delta_unpacker<data_size>& unpacker, delta_packer<data_size>& packer) {
+		command_stream stream{ tracking };
+		cobs_stream_decoder<delta_unpacker<data_size>::layout::MaxFrameSize> decoder;
+		std::vector<message_type> sent(count);
+		std::vector<byte_type> wire;
+		wire.reserve(count * delta_unpacker<data_size>::MaxEncodedSize);
+		run_result result;
+
+		auto begin = clock_type::now();
+		for (std::size_t i = 0; i < count; i++) {
+			stream.next(unpacker.as_item());
+			sent[i] = unpacker.as_item();
+			const auto requested = request_every != 0 && i % request_every == request_every / 2;
+			if (requested) unpacker.request_keyframe(sent[i].type);
+			if (!unpacker.unpack()) continue;
+			const auto frame = unpacker.as_buffer();
+			result.wire_bytes += frame.size();
+			if (requested || (drop_every != 0 && i % drop_every == drop_every - 1)) continue;
+			wire.insert(wire.end(), frame.begin(), frame.end());
+		}
+		result.unpack_ns = to_ns(clock_type::now() - begin);
+
+		std::vector<message_type> received;
+		received.reserve(count);
+		begin = clock_type::now();
+		decoder.feed(wire, [&](const_byte_span frame) {
+			message_type message{};
+			if (packer.pack(frame, message)) received.push_back(message);
+		});
+		result.pack_ns = to_ns(clock_type::now() - begin);
+
+		// 丢帧时接收序列是发送序列的子序列，在相邻的几帧中按顺序匹配
+		std::size_t cursor{ 0 };
+		for (const auto& message : received) {
+			auto match = cursor;
+			while (match < count && match < cursor + 8 && std::memcmp(&sent[match], &message, sizeof(message)) != 0) ++match;
+			if (match == count || match == cursor + 8) ++result.mismatched;
+			else cursor = match + 1;
+		}
+		result.delivered = received.size();
+		return result;
+	}
+
+	void report(const std::string& name, std::size_t count, const run_result& result, std::size_t full_size) {
+		const auto average = static_cast<double>(result.wire_bytes) / static_cast<double>(count);
+		std::cout << std::format("{:26} {:6.2f} B/msg ({:5.1f}% of full)  {:7.0f} msg/s at 115200  "
+			"unpack {:6.1f} ns/msg  pack {:6.1f} ns/msg  delivered {:6}/{} ({:5.1f}%)  mismatched {}\n",
+			name, average, 100.0 * average / static_cast<double>(full_size), uart_bytes_per_second / average,
+			static_cast<double>(result.unpack_ns) / static_cast<double>(count),
+			static_cast<double>(result.pack_ns) / static_cast<double>(count), result.delivered, count,
+			100.0 * static_cast<double>(result.delivered) / static_cast<double>(count), result.mismatched);
+	}
+
+	void scenario(const std::string& name, bool tracking, std::size_t keyframe_interval, std::size_t drop_every,
+		std::size_t request_every = 0) {
+		constexpr std::size_t count = 100000;
+		delta_unpacker<data_size> unpacker{ keyframe_interval };
+		delta_packer<data_size> packer{ frame_head, frame_tail };
+		const auto result = run_delta(tracking, count, drop_every, request_every, unpacker, packer);
+		auto label = std::format("{}/kf{}/drop{}", name, keyframe_interval, drop_every);
+		if (request_every != 0) label += std::format("/req{}", request_every);
+		report(label, count, result, sizeof(message_type));
+		std::cout << std::format("{:26} keyframes {}  deltas {}  receiver errors {}  resync drops {}\n", "",
+			unpacker.get_keyframe_count(), unpacker.get_delta_count(), packer.get_error_count(), packer.get_resync_count());
+	}
+
+	/// @brief 请求的关键帧丢失后，接收端不能把之后的差分帧应用到旧关键帧上
+	void lost_requested_keyframe() {
+		using small_unpacker = delta_unpacker<8>;
+		small_unpacker unpacker{ 32 };
+		delta_packer<8> packer{ frame_head, frame_tail };
+		cobs_stream_decoder<small_unpacker::layout::MaxFrameSize> decoder;
+		typed_message<8> received{};
+		std::size_t delivered{ 0 };
+		const auto send = [&](const byte_array<8>& data, bool lost) {
+			unpacker.as_item().type = 1;
+			unpacker.as_item().data = data;
+			unpacker.unpack();
+			if (lost) return;
+			decoder.feed(unpacker.as_buffer(), [&](const_byte_span frame) {
+				if (packer.pack(frame, received)) ++delivered;
+			});
+		};
+
+		send({ 1, 1, 1, 1, 1, 1, 1, 1 }, false);
+		unpacker.request_keyframe(1);
+		send({ 9, 9, 9, 9, 9, 9, 9, 9 }, true);
+		send({ 9, 9, 9, 9, 9, 9, 9, 7 }, false);
+		std::cout << std::format("{:26} delivered {}/2  stale delta {}  resync drops {}\n", "lost requested keyframe",
+			delivered, delivered == 2 ? "APPLIED" : "rejected", packer.get_resync_count());
+	}
+}
+
+int main() {
+	const auto full = static_cast<double>(sizeof(message_type));
+	std::cout << std::format("{:26} {:6.2f} B/msg (100.0% of full)  {:7.0f} msg/s at 115200\n",
+		"full typed_message", full, uart_bytes_per_second / full);
+	scenario("tracking", true, 32, 0);
+	scenario("tracking", true, 8, 0);
+	scenario("tracking", true, 32, 100);
+	scenario("hold", false, 32, 0);
+	scenario("hold", false, 128, 0);
+	scenario("hold", false, 32, 100);
+	scenario("hold", false, 128, 100);
+	scenario("tracking", true, 32, 10);
+	scenario("tracking", true, 32, 0, 250);
+	lost_requested_keyframe();
+	return 0;
+}
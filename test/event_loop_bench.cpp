@@ -0,0 +1,194 @@
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pty.h>
+#include <unistd.h>
+
+#include <ly/communicating/core/basic_tasks.hpp>
+#include <ly/communicating/core/spsc_queue.hpp>
+#include <ly/communicating/posix/event_loop.hpp>
+#include <ly/communicating/posix/fd_rwer.hpp>
+#include <ly/communicating/posix/serial_port.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	struct frame {
+		std::int64_t sent_ns;
+		std::uint32_t channel;
+		std::uint32_t sequence;
+	};
+
+	using queue_type = spsc_queue<frame, 1024>;
+
+	std::int64_t now_ns() { return to_ns(clock_type::now().time_since_epoch()); }
+
+	struct frame_packer {
+		using item_type = frame;
+
+		bool pack(byte_span buffer, item_type& item) noexcept {
+			std::memcpy(&item, buffer.data(), sizeof(item));
+			return true;
+		}
+	};
+
+	struct frame_unpacker {
+		using item_type = frame;
+
+		bool unpack(const item_type& item, byte_span buffer) noexcept {
+			std::memcpy(buffer.data(), &item, sizeof(item));
+			return true;
+		}
+	};
+
+	/// @brief 记录每帧从生产者发出到事件循环投递的延迟，并检查序号是否连续
+	struct latency_sink {
+		using item_type = frame;
+
+		std::vector<std::int64_t> latency;
+		std::uint32_t next_sequence{ 0 };
+		std::size_t gaps{ 0 };
+
+		bool set(const item_type& item) noexcept {
+			latency.push_back(now_ns() - item.sent_ns);
+			if (item.sequence != next_sequence) ++gaps;
+			next_sequence = item.sequence + 1;
+			return true;
+		}
+	};
+
+	struct accept_monitor {
+		bool handle(int) noexcept { return true; }
+	};
+
+	/// @brief 事件循环中的一个读取通道，producer_fd 是生产者写入的一端
+	struct channel {
+		std::string kind;
+		int producer_fd{ -1 };
+		std::shared_ptr<latency_sink> sink{ std::make_shared<latency_sink>() };
+	};
+
+	template<typename device_type>
+	using loop_reader_task = reader_task<exact_reader<std::shared_ptr<device_type>>, frame_packer, latency_sink>;
+
+	/// @brief 把 device 上的读取任务注册到事件循环
+	/// @param through_device true 时使用接受读写器的重载，事件循环把读取超时设为 0 ；false 时只注册 fd ，读取器保留自己的超时
+	template<typename device_type>
+	void add_channel(posix::event_loop& loop, const std::shared_ptr<device_type>& device, channel& target,
+		bool through_device) {
+		auto task = std::make_shared<loop_reader_task<device_type>>(
+			std::make_shared<exact_reader<std::shared_ptr<device_type>>>(device), std::make_shared<frame_packer>(),
+			target.sink);
+		if (through_device) loop.add_reader(device, task, std::make_shared<accept_monitor>());
+		else loop.add_reader(device->native_handle(), task, std::make_shared<accept_monitor>());
+	}
+
+	/// @brief 一个线程上的事件循环驱动 pipe_count 个管道、pty_count 个伪终端，以及一个经 @c event_notifier 唤醒的写入任务
+	/// @details
+	///		生产者每 interval 向每个通道写入一帧，同时向写入任务的队列投递一帧，写入任务把它写进另一根管道，
+	///		该管道的读取端同样注册在事件循环中。统计各类通道的送达数量与延迟。
+	void run(std::size_t pipe_count, std::size_t pty_count, bool through_device, std::size_t count,
+		std::chrono::microseconds interval) {
+		posix::event_loop loop;
+		std::vector<channel> channels;
+		std::vector<std::shared_ptr<void>> devices;
+		channels.reserve(pipe_count + pty_count + 1);
+
+		for (std::size_t i = 0; i < pipe_count; i++) {
+			int fds[2];
+			if (::pipe(fds) != 0) return;
+			posix::details::set_nonblock(fds[1]);
+			auto device = std::make_shared<posix::fd_rwer>(fds[0]);
+			auto& target = channels.emplace_back(channel{ "pipe", fds[1] });
+			add_channel(loop, device, target, through_device);
+			devices.push_back(device);
+		}
+		for (std::size_t i = 0; i < pty_count; i++) {
+			int master{}, slave{};
+			if (::openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) {
+				std::cerr << "openpty failed" << std::endl;
+				return;
+			}
+			auto device = posix::serial_port::adopt(slave, posix::serial_options{});
+			auto& target = channels.emplace_back(channel{ "pty", master });
+			add_channel(loop, device, target, through_device);
+			devices.push_back(device);
+		}
+
+		// 写入任务：生产者 → 队列 → 通知 → 事件循环中的 writer_task → 管道 → 事件循环中的读取任务
+		int fds[2];
+		if (::pipe(fds) != 0) return;
+		auto& written = channels.emplace_back(channel{ "writer", -1 });
+		const auto output = std::make_shared<posix::fd_rwer>(fds[1]);
+		const auto input = std::make_shared<posix::fd_rwer>(fds[0]);
+		add_channel(loop, input, written, through_device);
+		const auto queue = std::make_shared<queue_type>();
+		const auto writer = std::make_shared<writer_task<exact_writer<std::shared_ptr<posix::fd_rwer>>, frame_unpacker,
+			queue_type>>(std::make_shared<exact_writer<std::shared_ptr<posix::fd_rwer>>>(output),
+			std::make_shared<frame_unpacker>(), queue);
+		const auto notifier = loop.add_writer(writer, std::make_shared<accept_monitor>());
+		posix::notifying_sink<queue_type> producer_sink{ queue, notifier };
+
+		std::thread runner{ [&] { loop.run(); } };
+
+		auto next = clock_type::now();
+		for (std::uint32_t sequence = 0; sequence < count; sequence++) {
+			next += interval;
+			std::this_thread::sleep_until(next);
+			for (std::size_t i = 0; i + 1 < channels.size(); i++) {
+				const frame value{ now_ns(), static_cast<std::uint32_t>(i), sequence };
+				(void)!::write(channels[i].producer_fd, &value, sizeof(value));
+			}
+			(void)producer_sink.set(frame{ now_ns(), static_cast<std::uint32_t>(channels.size() - 1), sequence });
+		}
+
+		// 等待最后的帧送达，最多 1 s
+		const auto deadline = clock_type::now() + 1s;
+		const auto delivered_all = [&] {
+			for (const auto& target : channels)
+				if (target.sink->next_sequence != count) return false;
+			return true;
+		};
+		while (!delivered_all() && clock_type::now() < deadline) std::this_thread::sleep_for(1ms);
+		loop.stop();
+		runner.join();
+
+		std::cout << std::format("{} pipes + {} ptys + 1 writer, {}, {} frames/channel every {} us\n",
+			pipe_count, pty_count, through_device ? "add_reader(device): read_timeout 0" :
+			"add_reader(fd): read_timeout 10 ms", count, interval.count());
+		for (const auto kind : { "pipe", "pty", "writer" }) {
+			std::vector<std::int64_t> latency;
+			std::size_t delivered{ 0 }, sent{ 0 }, gaps{ 0 };
+			for (const auto& target : channels) {
+				if (target.kind != kind) continue;
+				latency.insert(latency.end(), target.sink->latency.begin(), target.sink->latency.end());
+				delivered += target.sink->latency.size();
+				sent += count;
+				gaps += target.sink->gaps;
+			}
+			if (sent == 0) continue;
+			std::cout << std::format("  {:6}  delivered {:6}/{:<6}  gaps {:3}  p50 {:9} ns  p99 {:9} ns  max {:9} ns\n",
+				kind, delivered, sent, gaps, percentile(latency, 0.5), percentile(latency, 0.99),
+				percentile(latency, 1.0));
+		}
+		for (const auto& target : channels)
+			if (target.producer_fd >= 0) ::close(target.producer_fd);
+	}
+}
+
+int main() {
+	run(4, 2, true, 2000, 1000us);
+	// 对照组：只注册 fd ，每次唤醒的最后一次读取都会在 poll 中等待 10 ms ，阻塞循环中的其他通道
+	run(4, 2, false, 200, 1000us);
+	return 0;
+}
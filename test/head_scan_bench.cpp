@@ -0,0 +1,115 @@
+#include <iostream>
+#include <format>
+#include <random>
+#include <ranges>
+#include <vector>
+
+#include <ly/communicating/core/byte_scan.hpp>
+#include <ly/communicating/core/ping_pong_buffer.hpp>
+#include <ly/communicating/core/ring_decoder.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	constexpr byte_type head = 0xA5;
+	constexpr size_type frame_size = 32;
+	constexpr size_type stream_size = 1 << 20;
+
+	bool xor_verify(const_byte_span span) {
+		byte_type sum{ 0 };
+		for (const auto byte : span.first(span.size() - 1)) sum ^= byte;
+		return sum == span.back();
+	}
+
+	/// @brief 改动前的实现，逐字节查找头字节
+	bool legacy_find_head_byte(const_byte_span& span, byte_type value) noexcept {
+		const auto head_index = std::ranges::find(span, value);
+		if (head_index == span.end()) return false;
+		span = span.subspan(head_index - span.begin());
+		return true;
+	}
+
+	/// @brief 生成连续的数据包，noise_rate 为每个数据包之前插入随机噪声的概率
+	std::vector<byte_type> make_stream(double noise_rate) {
+		std::mt19937 random{ 42 };
+		std::bernoulli_distribution noisy{ noise_rate };
+		std::vector<byte_type> stream;
+		stream.reserve(stream_size + frame_size * 2);
+		while (stream.size() < stream_size) {
+			if (noisy(random))
+				for (auto i = random() % (frame_size * 4); i > 0; i--) stream.push_back(static_cast<byte_type>(random()));
+			byte_array<frame_size> frame{};
+			frame[0] = head;
+			for (size_type i = 1; i < frame_size - 1; i++) frame[i] = static_cast<byte_type>(random() % 0x80);
+			frame.back() = 0;
+			frame.back() = [&] { byte_type sum{ 0 }; for (auto b : frame) sum ^= b; return sum; }();
+			stream.insert(stream.end(), frame.begin(), frame.end());
+		}
+		return stream;
+	}
+
+	/// @brief 统计所有头字节出现的位置
+	template<typename find_type>
+	size_type count_heads(const std::vector<byte_type>& stream, find_type&& find) {
+		size_type count{ 0 };
+		const_byte_span span{ stream };
+		while (find(span, head)) {
+			++count;
+			span = span.subspan(1);
+		}
+		return count;
+	}
+
+	/// @brief 改动前的失步处理：每次失败只前进一个字节，然后重新查找头字节
+	size_type legacy_decode(const std::vector<byte_type>& stream) {
+		size_type count{ 0 };
+		const_byte_span span{ stream };
+		while (span.size() >= frame_size && legacy_find_head_byte(span, head)) {
+			if (span.size() < frame_size) break;
+			if (xor_verify(span.first(frame_size))) {
+				++count;
+				span = span.subspan(frame_size);
+			}
+			else span = span.subspan(1);
+		}
+		return count;
+	}
+
+	size_type ring_decode(const std::vector<byte_type>& stream) {
+		ring_frame_decoder<frame_size, xor_verify, 1 << 16> decoder{ head };
+		return decoder.feed(stream, [](const_byte_span frame) { do_not_optimize(frame.data()); });
+	}
+
+	void run_group(std::string_view name, double noise_rate) {
+		constexpr std::size_t iterations = 20;
+		const auto stream = make_stream(noise_rate);
+		const auto bytes = static_cast<double>(stream.size());
+
+		size_type legacy_heads{}, heads{}, legacy_frames{}, frames{};
+		const auto legacy_scan = ns_per_op(iterations, [&] { legacy_heads = count_heads(stream, legacy_find_head_byte); });
+		const auto scan = ns_per_op(iterations, [&] { heads = count_heads(stream, find_head_byte); });
+
+		std::vector<size_type> offsets(stream.size());
+		size_type listed{};
+		const auto scan_list = ns_per_op(iterations, [&] { listed = scan_bytes(stream, head, offsets); });
+
+		const auto legacy_decoding = ns_per_op(iterations, [&] { legacy_frames = legacy_decode(stream); });
+		const auto decoding = ns_per_op(iterations, [&] { frames = ring_decode(stream); });
+
+		std::cout << std::format("[{}] {} bytes, {} heads, {} frames\n", name, stream.size(), heads, frames);
+		std::cout << std::format("  legacy find_head_byte loop : {:8.3f} ns/KB ({} heads)\n", legacy_scan / bytes * 1024, legacy_heads);
+		std::cout << std::format("  simd find_head_byte loop   : {:8.3f} ns/KB\n", scan / bytes * 1024);
+		std::cout << std::format("  simd scan_bytes index list : {:8.3f} ns/KB ({} heads)\n", scan_list / bytes * 1024, listed);
+		std::cout << std::format("  legacy resync decode       : {:8.3f} ns/KB ({} frames)\n", legacy_decoding / bytes * 1024, legacy_frames);
+		std::cout << std::format("  ring_frame_decoder         : {:8.3f} ns/KB\n", decoding / bytes * 1024);
+	}
+}
+
+int main() {
+	run_group("clean", 0.0);
+	run_group("noisy", 0.3);
+	return 0;
+}
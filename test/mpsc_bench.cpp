@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <ly/communicating/core/basic_tasks.hpp>
+#include <ly/communicating/core/mpsc_queue.hpp>
+#include <ly/communicating/core/typed_message.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	struct stamp {
+		std::int64_t pushed_ns;
+		std::uint32_t sequence;
+		std::uint32_t producer;
+	};
+
+	using message_type = typed_message_wrap<stamp>;
+	using queue_type = mpsc_queue<message_type, 1024>;
+
+	constexpr std::size_t max_producer_count = 8;
+	constexpr std::size_t messages_per_producer = 100000;
+
+	std::int64_t now_ns() {
+		return to_ns(clock_type::now().time_since_epoch());
+	}
+
+	/// @brief 不产生实际 IO 的写入器
+	struct null_writer {
+		std::size_t bytes{ 0 };
+
+		bool write(byte_span buffer) {
+			bytes += buffer.size();
+			return true;
+		}
+	};
+
+	/// @brief 拆包时记录排队延迟，并检查同一写入者的数据是否按顺序到达
+	struct stamp_unpacker {
+		using item_type = message_type;
+
+		std::vector<std::int64_t> latencies;
+		std::array<std::uint32_t, max_producer_count> next_sequence{};
+		std::size_t reorder{ 0 };
+
+		bool unpack(const item_type& item, byte_span buffer) {
+			stamp value{};
+			item.data_to(value);
+			latencies.push_back(now_ns() - value.pushed_ns);
+			if (value.sequence != next_sequence[value.producer]) ++reorder;
+			next_sequence[value.producer] = value.sequence + 1;
+			std::ranges::copy(item.as_span(), buffer.begin());
+			return true;
+		}
+	};
+
+	void run(std::size_t producer_count) {
+		auto queue = std::make_shared<queue_type>();
+		auto writer = std::make_shared<null_writer>();
+		auto unpacker = std::make_shared<stamp_unpacker>();
+		unpacker->latencies.reserve(producer_count * messages_per_producer);
+		writer_task<null_writer, stamp_unpacker, queue_type> task{ writer, unpacker, queue };
+
+		std::atomic_size_t full_count{ 0 };
+		std::vector<std::thread> producers;
+		const auto begin = clock_type::now();
+		for (std::size_t id = 0; id < producer_count; id++)
+			producers.emplace_back([&, id] {
+				message_type message{};
+				for (std::uint32_t sequence = 0; sequence < messages_per_producer; sequence++) {
+					message.data_from(stamp{ now_ns(), sequence, static_cast<std::uint32_t>(id) });
+					while (!queue->push(message)) {
+						full_count.fetch_add(1, std::memory_order_relaxed);
+						std::this_thread::yield();
+					}
+				}
+			});
+
+		// 单个 writer_task 排空队列
+		const auto total = producer_count * messages_per_producer;
+		while (unpacker->latencies.size() < total)
+			if (task.run_once() != 0) std::this_thread::yield();
+		const auto elapsed = to_ns(clock_type::now() - begin);
+		for (auto& producer : producers) producer.join();
+
+		auto& latencies = unpacker->latencies;
+		std::cout << std::format(
+			"producers={} throughput={:.2f} Mmsg/s p50={} ns p99={} ns p99.9={} ns max={} ns "
+			"cas_retry/msg={:.4f} full_retry/msg={:.4f} reorder={}\n",
+			producer_count,
+			static_cast<double>(total) * 1e3 / static_cast<double>(elapsed),
+			percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999),
+			latencies.back(),
+			static_cast<double>(queue->contention_count()) / static_cast<double>(total),
+			static_cast<double>(full_count.load()) / static_cast<double>(total),
+			unpacker->reorder);
+	}
+}
+
+int main() {
+	for (const std::size_t producer_count : { 1, 2, 4, 8 })
+		run(producer_count);
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include <ly/communicating/posix/realtime_thread.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	/// @brief 周期性唤醒的任务，记录每次实际唤醒时间与预定时间之差
+	struct periodic_task {
+		std::chrono::nanoseconds period;
+		std::vector<std::int64_t>* samples;
+		std::size_t count;
+
+		void operator()() const {
+			timespec next{};
+			::clock_gettime(CLOCK_MONOTONIC, &next);
+			for (std::size_t i = 0; i < count; i++) {
+				next.tv_nsec += static_cast<long>(period.count());
+				while (next.tv_nsec >= 1'000'000'000) {
+					next.tv_nsec -= 1'000'000'000;
+					++next.tv_sec;
+				}
+				while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+				timespec now{};
+				::clock_gettime(CLOCK_MONOTONIC, &now);
+				(*samples)[i] = (now.tv_sec - next.tv_sec) * 1'000'000'000 + (now.tv_nsec - next.tv_nsec);
+			}
+		}
+	};
+
+	/// @brief 普通优先级的忙循环线程，与被测线程争用 CPU
+	class background_load {
+		std::atomic<bool> stopping{ false };
+		std::vector<std::thread> threads;
+
+	public:
+		explicit background_load(std::size_t count) {
+			for (std::size_t i = 0; i < count; i++)
+				threads.emplace_back([this] {
+					std::uint64_t value{ 0 };
+					while (!stopping.load(std::memory_order_relaxed)) do_not_optimize(++value);
+				});
+		}
+
+		~background_load() {
+			stopping.store(true, std::memory_order_relaxed);
+			for (auto& thread : threads) thread.join();
+		}
+	};
+
+	void run(const std::string& name, const posix::realtime_options& options, std::size_t load, std::size_t count) {
+		std::vector<std::int64_t> samples(count);
+		background_load background{ load };
+
+		posix::realtime_report report;
+		{
+			posix::realtime_thread thread{ options, [&] {
+				if (options.lock_memory)
+					posix::prefault({ reinterpret_cast<byte_type*>(samples.data()), samples.size() * sizeof(std::int64_t) });
+				periodic_task{ 1ms, &samples, count }();
+			} };
+			report = thread.get_report();
+		}
+		// mlockall 作用于整个进程，解锁以免影响后续的对照组
+		if (report.memory_locked) ::munlockall();
+
+		const auto worst = *std::ranges::max_element(samples);
+		std::cout << std::format("{:10} load {:2}  wake-up latency ns  p50 {:8}  p99 {:8}  p99.9 {:8}  max {:9}\n",
+			name, load, percentile(samples, 0.5), percentile(samples, 0.99), percentile(samples, 0.999), worst);
+		for (const auto& warning : report.warnings) std::cout << std::format("{:10}   fallback: {}\n", "", warning);
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+
+	const posix::realtime_options plain;
+	posix::realtime_options fifo{
+		.cpus = {},
+		.use_isolated_cpus = true,
+		.policy = posix::scheduling_policy::fifo,
+		.priority = 80,
+		.lock_memory = true,
+		.prefault_stack = 256 * 1024,
+	};
+	posix::realtime_options deadline{
+		.cpus = {},
+		.policy = posix::scheduling_policy::deadline,
+		.lock_memory = true,
+		.prefault_stack = 256 * 1024,
+	};
+
+	const auto cpus = std::thread::hardware_concurrency();
+	for (const std::size_t load : { std::size_t{ 0 }, std::size_t{ cpus * 2 } }) {
+		run("plain", plain, load, count);
+		run("fifo", fifo, load, count);
+		run("deadline", deadline, load, count);
+	}
+	return 0;
+}
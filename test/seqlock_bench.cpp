@@ -0,0 +1,97 @@
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <ly/communicating/core/sao_item.hpp>
+#include <ly/communicating/core/seqlock_item.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	/// @brief 约 200 字节的云台状态，大于 16 字节时 std::atomic 会退化为内部加锁
+	struct gimbal_state {
+		std::uint64_t index;
+		double values[24];
+	};
+
+	gimbal_state make_state(std::uint64_t index) {
+		gimbal_state state{ index, {} };
+		for (auto& value : state.values) value = static_cast<double>(index);
+		return state;
+	}
+
+	/// @brief 数据被撕裂时，各字段的值会不一致
+	bool is_torn(const gimbal_state& state) {
+		for (const auto value : state.values)
+			if (value != static_cast<double>(state.index)) return true;
+		return false;
+	}
+
+	struct result {
+		double set_ns;
+		double get_ns;
+		std::size_t torn;
+	};
+
+	/// @brief 一个写入线程持续写入，reader_count 个读取线程持续读取，测量平均每次操作耗时
+	template<typename item_type>
+	result run(item_type& item, std::size_t reader_count) {
+		constexpr auto duration = 200ms;
+		std::atomic_bool running{ true };
+		std::atomic_size_t gets{ 0 }, torn{ 0 };
+		std::atomic<std::int64_t> get_time{ 0 };
+
+		std::vector<std::thread> readers;
+		for (std::size_t i = 0; i < reader_count; i++)
+			readers.emplace_back([&] {
+				gimbal_state state{};
+				std::size_t count{ 0 }, local_torn{ 0 };
+				const auto begin = clock_type::now();
+				while (running.load(std::memory_order_relaxed)) {
+					if (item.get(state) && is_torn(state)) ++local_torn;
+					++count;
+				}
+				get_time += to_ns(clock_type::now() - begin);
+				gets += count;
+				torn += local_torn;
+			});
+
+		std::size_t sets{ 0 };
+		const auto begin = clock_type::now();
+		while (clock_type::now() - begin < duration) {
+			item.set(make_state(sets));
+			++sets;
+		}
+		const auto set_time = to_ns(clock_type::now() - begin);
+		running = false;
+		for (auto& reader : readers) reader.join();
+
+		return {
+			static_cast<double>(set_time) / static_cast<double>(sets),
+			static_cast<double>(get_time) / static_cast<double>(gets),
+			torn
+		};
+	}
+
+	void print(std::string_view name, std::size_t reader_count, const result& r) {
+		std::cout << std::format("{:<28} readers={} set={:8.1f} ns get={:8.1f} ns torn={}\n",
+			name, reader_count, r.set_ns, r.get_ns, r.torn);
+	}
+}
+
+int main() {
+	for (const std::size_t reader_count : { 1, 2, 4 }) {
+		auto atomic_item = shared_atomic_optional_item<gimbal_state>::make();
+		print("shared_atomic_optional_item", reader_count, run(atomic_item, reader_count));
+
+		seqlock_item<gimbal_state> seqlock;
+		print("seqlock_item", reader_count, run(seqlock, reader_count));
+	}
+	return 0;
+}
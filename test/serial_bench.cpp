@@ -0,0 +1,76 @@
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <pty.h>
+
+#include <ly/communicating/posix/serial_port.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	constexpr std::size_t round_count = 5000;
+
+	/// @brief 读满整个缓冲区，超时返回 false
+	bool read_all(byte_rwer& rwer, byte_span buffer) {
+		while (!buffer.empty()) {
+			const auto bytes = rwer.read(buffer);
+			if (bytes == 0) return false;
+			buffer = buffer.subspan(bytes);
+		}
+		return true;
+	}
+
+	void run(std::size_t frame_size) {
+		int master{}, slave{};
+		if (::openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) {
+			std::cerr << "openpty failed" << std::endl;
+			return;
+		}
+
+		posix::serial_options options{};
+		options.read_timeout = 100ms;
+		const auto device = posix::serial_port::adopt(slave, options);
+		const auto remote = posix::serial_port::adopt(master, options);
+
+		// 远端原样回显
+		std::atomic_bool running{ true };
+		std::thread echo{ [&] {
+			std::vector<byte_type> buffer(4096);
+			while (running) {
+				const auto bytes = remote->read(buffer);
+				if (bytes != 0) (void)remote->write(const_byte_span{ buffer.data(), bytes });
+			}
+		} };
+
+		std::vector<byte_type> frame(frame_size), echoed(frame_size);
+		std::vector<std::int64_t> rtt;
+		rtt.reserve(round_count);
+		std::size_t corrupted{ 0 };
+		for (std::size_t i = 0; i < round_count; i++) {
+			for (auto& byte : frame) byte = static_cast<byte_type>(i);
+			const auto begin = clock_type::now();
+			if (device->write(frame) != frame.size() || !read_all(*device, echoed)) break;
+			rtt.push_back(to_ns(clock_type::now() - begin));
+			if (echoed != frame) ++corrupted;
+		}
+		running = false;
+		echo.join();
+
+		std::cout << std::format("frame={:>4} B rounds={} p50={} ns p99={} ns p99.9={} ns corrupted={} low_latency={}\n",
+			frame_size, rtt.size(), percentile(rtt, 0.5), percentile(rtt, 0.99), percentile(rtt, 0.999),
+			corrupted, device->is_low_latency());
+	}
+}
+
+int main() {
+	for (const std::size_t frame_size : { 16, 64, 256 })
+		run(frame_size);
+	return 0;
+}
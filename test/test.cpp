@@ -2,10 +2,13 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <ctime>
 #include <fstream>
 
 #include <ly/communicating/core/basic_tasks.hpp>
+#include <ly/communicating/core/idle_policy.hpp>
 #include <ly/communicating/core/sao_item.hpp>
+#include <ly/communicating/core/spsc_queue.hpp>
 #include <ly/communicating/core/triple_pool.hpp>
 
 namespace ly::communicating {
@@ -61,6 +64,9 @@ namespace {
 	template<typename TItem>
 	using tri_item = cango::utility::nonblock_triple_item_pool<TItem>;
 
+	template<typename TItem>
+	using spsc_item = ly::communicating::spsc_queue<TItem, 2048>;
+
 	template<typename TItem>
 	class sa_item final {
 		std::shared_ptr<std::atomic<TItem>> Item{ std::make_shared<std::atomic<TItem>>() };
@@ -77,6 +83,25 @@ namespace {
 		}
 	};
 
+	/// @brief 写入后通知 wake_signal 的存储，使读取端可以使用 parking_idle 停车等待
+	template<typename target_type>
+	class waking_item final {
+		target_type target;
+
+	public:
+		using item_type = typename target_type::item_type;
+		std::shared_ptr<ly::communicating::wake_signal> signal{ std::make_shared<ly::communicating::wake_signal>() };
+
+		void push(const item_type& item) noexcept {
+			target.push(item);
+			signal->notify();
+		}
+
+		[[nodiscard]] bool pop(item_type& item) noexcept {
+			return target.pop(item);
+		}
+	};
+
 	template<std::size_t extra_size = 10>
 	struct fake_data {
 		std::uint32_t index;
@@ -151,7 +176,8 @@ namespace {
 		}
 
 		/// @brief 读取，保存数据。在没有读取到数据时调用 idle_sleep，在读取到数据后调用 work_sleep
-		static void read_task(auto& source, pulling_table& table, auto& idle_sleep, auto& work_sleep) {
+		///	@param reorder_count 读到比上一次更旧的数据的次数
+		static void read_task(auto& source, pulling_table& table, std::size_t& reorder_count, auto& idle_sleep, auto& work_sleep) {
 			auto last_index = count;
 			while (true) {
 				pulling_info info{};
@@ -161,6 +187,11 @@ namespace {
 					continue;
 				}
 				info.acquired_time = clock_type::now();
+				if (last_index != count && info.data.index < last_index) {
+					std::cout << "reorder ";
+					++reorder_count;
+					continue;
+				}
 				for (; info.data.index != 0 && last_index < info.data.index - 1; last_index++)
 					std::cout << "lost ";
 				std::cout << info.data.index << ' ';
@@ -173,7 +204,7 @@ namespace {
 			std::cout << std::endl;
 		}
 
-		static void summary(std::ostream& stream, const time_type begin, const pushing_table& tWrite, const pulling_table& tRead) {
+		static void summary(std::ostream& stream, const time_type begin, const pushing_table& tWrite, const pulling_table& tRead, std::size_t reorder_count) {
 			const auto invalid_duration = begin - begin;
 
 			std::vector<summary_info> sum;
@@ -215,27 +246,38 @@ namespace {
 			const auto loss_count = count - sum.size();
 			stream << average.format_average(count) << std::endl;
 			stream << std::format("loss: {}/{}", loss_count, count) << std::endl;
+			stream << std::format("reorder: {}", reorder_count) << std::endl;
 		}
 
 		struct executor {
 			pushing_table t_write;
 			pulling_table t_read;
+			std::size_t reorder_count{ 0 };
 			time_type begin;
+			time_type end;
+			std::clock_t cpu_cost{ 0 };
 
 			void execute(auto& item, auto& sleep, auto& idle_sleep, auto& work_sleep) {
+				const auto cpu_begin = std::clock();
 				std::thread write_thread{ [&item, this, &sleep] {
 					write_task(item, t_write, sleep);
 				} };
 				std::thread read_thread{ [&item, this, &idle_sleep, &work_sleep] {
-					read_task(item, t_read, idle_sleep, work_sleep);
+					read_task(item, t_read, reorder_count, idle_sleep, work_sleep);
 				} };
 				begin = clock_type::now();
 				write_thread.join();
 				read_thread.join();
+				end = clock_type::now();
+				cpu_cost = std::clock() - cpu_begin;
 			}
 
 			void summary(std::ostream& stream) const {
-				io_tasks::summary(stream, begin, t_write, t_read);
+				io_tasks::summary(stream, begin, t_write, t_read, reorder_count);
+				// 进程 CPU 时间，写入端几乎一直在休眠，主要反映读取端的空闲策略开销
+				const auto wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+				const auto cpu_ms = cpu_cost * 1000 / CLOCKS_PER_SEC;
+				stream << std::format("cpu: {}ms/{}ms ({}%)", cpu_ms, wall_ms, wall_ms == 0 ? 0 : cpu_ms * 100 / wall_ms) << std::endl;
 			}
 		};
 	};
@@ -255,6 +297,26 @@ namespace {
 		executor.execute(target, sleep<w_ms>, sleep<ri_ms>, sleep<rw_ms>);
 		executor.summary(stream);
 	};
+
+	/// @brief 读取端使用空闲策略代替固定休眠：没有读取到数据时调用 idle ，读取到数据后调用 reset
+	template<template<typename> typename target_type, typename idle_type, std::size_t extra_data = 10, std::size_t count = 1000, std::size_t w_ms = 1>
+	void fake_data_idle_benchmark(std::string_view filepath) {
+		using data_type = fake_data<extra_data>;
+		using task_type = io_tasks<data_type, count>;
+		typename task_type::executor executor;
+		waking_item<target_type<data_type>> target;
+		auto idle = [&target] {
+			if constexpr (std::constructible_from<idle_type, std::shared_ptr<ly::communicating::wake_signal>>)
+				return idle_type{ target.signal };
+			else
+				return idle_type{};
+		}();
+		auto idle_sleep = [&idle] { idle.idle(); };
+		auto work_sleep = [&idle] { idle.reset(); };
+		std::ofstream stream{ filepath.data() };
+		executor.execute(target, sleep<w_ms>, idle_sleep, work_sleep);
+		executor.summary(stream);
+	}
 }
 
 int main() {
@@ -277,5 +339,26 @@ int main() {
 	fake_data_benchmark<tri_item, 10, 1000, 2, 0, 10>("tri1_10_1000_2_0_10.txt");
 
 
+	// group 4
+	// 10 字节额外数据，1000 次写入，写入间隔 1ms，读取空闲间隔 0ms，读取工作间隔 0ms，读取端几乎一直在拉取，用于观察拉取开销与乱序
+	fake_data_benchmark<sa_item, 10, 1000, 1, 0, 0>("sa1_10_1000_1_0_0.txt");
+	fake_data_benchmark<tri_item, 10, 1000, 1, 0, 0>("tri1_10_1000_1_0_0.txt");
+
+
+	// group 5
+	// 与 group 2 相同，读取慢于写入时，最新值存储会丢失数据，而队列不会
+	fake_data_benchmark<spsc_item, 10, 1000, 2, 1, 10>("spsc1_10_1000_2_1_10.txt");
+
+
+	// group 6
+	// 10 字节额外数据，1000 次写入，写入间隔 1ms，比较读取端空闲策略的唤醒延迟（delay）与 CPU 占用（cpu）
+	// 基准为固定休眠 1ms ，其余依次为忙等、忙等后让出、指数退避、停车等待
+	fake_data_benchmark<spsc_item, 10, 1000, 1, 1, 0>("spsc_idle_sleep.txt");
+	fake_data_idle_benchmark<spsc_item, ly::communicating::spin_idle>("spsc_idle_spin.txt");
+	fake_data_idle_benchmark<spsc_item, ly::communicating::spin_yield_idle<>>("spsc_idle_spin_yield.txt");
+	fake_data_idle_benchmark<spsc_item, ly::communicating::backoff_idle<>>("spsc_idle_backoff.txt");
+	fake_data_idle_benchmark<spsc_item, ly::communicating::parking_idle<>>("spsc_idle_parking.txt");
+
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+
+#include <ly/communicating/core/cpu_hint.hpp>
+#include <ly/communicating/posix/uring.hpp>
+
+#include "bench_common.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+	using namespace ly::communicating;
+	using namespace ly::communicating::bench;
+
+	struct frame {
+		std::int64_t sent_ns;
+		std::uint64_t sequence;
+	};
+
+	constexpr std::size_t frame_count = 20000;
+	constexpr auto frame_interval = 20us;
+
+	std::int64_t now_ns() {
+		return to_ns(clock_type::now().time_since_epoch());
+	}
+
+	/// @brief 一对 fd ，first 读取，second 写入
+	using fd_pair = std::pair<int, int>;
+
+	fd_pair make_pipe() {
+		int fds[2]{};
+		if (::pipe(fds) != 0) posix::details::throw_errno("pipe");
+		return { fds[0], fds[1] };
+	}
+
+	fd_pair make_pty() {
+		int master{}, slave{};
+		if (::openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) posix::details::throw_errno("openpty");
+		for (const auto fd : { master, slave }) {
+			termios tty{};
+			::tcgetattr(fd, &tty);
+			::cfmakeraw(&tty);
+			::tcsetattr(fd, TCSANOW, &tty);
+		}
+		return { master, slave };
+	}
+
+	/// @brief 按固定间隔向各个 fd 轮流写入数据包
+	std::thread start_sender(const std::vector<fd_pair>& pairs) {
+		return std::thread{ [pairs] {
+			auto next = clock_type::now();
+			for (std::uint64_t sequence = 0; sequence < frame_count; sequence++) {
+				while (clock_type::now() < next) cpu_relax();
+				next += frame_interval;
+				const frame value{ now_ns(), sequence };
+				(void)posix::details::write_all(pairs[sequence % pairs.size()].second,
+					const_byte_span{ reinterpret_cast<const byte_type*>(&value), sizeof(value) }, 100ms);
+			}
+		} };
+	}
+
+	/// @brief 从每个通道累积的字节中取出完整的数据包并记录延迟
+	struct receiver {
+		std::vector<std::vector<byte_type>> pending;
+		std::vector<std::int64_t> latencies;
+
+		explicit receiver(std::size_t channel_count) : pending(channel_count) {
+			latencies.reserve(frame_count);
+		}
+
+		void receive(std::size_t channel, const_byte_span bytes) {
+			const auto now = now_ns();
+			auto& buffer = pending[channel];
+			buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+			std::size_t offset{ 0 };
+			for (; offset + sizeof(frame) <= buffer.size(); offset += sizeof(frame)) {
+				frame value{};
+				std::memcpy(&value, buffer.data() + offset, sizeof(value));
+				latencies.push_back(now - value.sent_ns);
+			}
+			buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+		}
+
+		[[nodiscard]] bool done() const { return latencies.size() >= frame_count; }
+	};
+
+	void report(const char* name, std::vector<std::int64_t>& latencies, std::size_t syscalls) {
+		std::cout << std::format("{:<24} frames={} syscall/frame={:.3f} p50={} ns p99={} ns p99.9={} ns\n",
+			name, latencies.size(),
+			static_cast<double>(syscalls) / static_cast<double>(std::max<std::size_t>(latencies.size(), 1)),
+			percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999));
+	}
+
+	/// @brief 普通读取：poll 等待所有 fd ，再逐个 read 就绪的 fd
+	void plain_read(const char* name, const std::vector<fd_pair>& pairs) {
+		for (const auto& pair : pairs) posix::details::set_nonblock(pair.first);
+		receiver result{ pairs.size() };
+		auto sender = start_sender(pairs);
+
+		std::vector<pollfd> targets;
+		for (const auto& pair : pairs) targets.push_back({ pair.first, POLLIN, 0 });
+		std::array<byte_type, 16384> buffer{};
+		std::size_t syscalls{ 0 };
+		while (!result.done()) {
+			++syscalls;
+			if (::poll(targets.data(), targets.size(), 100) <= 0) break;
+			for (std::size_t i = 0; i < targets.size(); i++) {
+				if (!(targets[i].revents & POLLIN)) continue;
+				++syscalls;
+				const auto bytes = ::read(targets[i].fd, buffer.data(), buffer.size());
+				if (bytes > 0) result.receive(i, const_byte_span{ buffer.data(), static_cast<std::size_t>(bytes) });
+			}
+		}
+		sender.join();
+		for (const auto& pair : pairs) {
+			::close(pair.first);
+			::close(pair.second);
+		}
+		report(name, result.latencies, syscalls);
+	}
+
+	/// @brief io_uring 读取：每个通道保持一个读取请求在途，同一个上下文一次等待收割所有通道
+	void uring_read(const char* name, const std::vector<fd_pair>& pairs) {
+		const auto context = posix::uring_context::create();
+		if (!context) {
+			std::cout << std::format("{:<24} io_uring unavailable\n", name);
+			for (const auto& pair : pairs) {
+				::close(pair.first);
+				::close(pair.second);
+			}
+			return;
+		}
+#if LY_COMMUNICATING_IO_URING
+		std::vector<std::shared_ptr<posix::uring_channel>> channels;
+		for (const auto& pair : pairs) channels.push_back(std::make_shared<posix::uring_channel>(context, pair.first));
+		receiver result{ pairs.size() };
+		auto sender = start_sender(pairs);
+
+		const auto begin = context->syscall_count();
+		while (!result.done()) {
+			bool received{ false };
+			for (std::size_t i = 0; i < channels.size(); i++) {
+				const auto bytes = channels[i]->peek(0ns);
+				if (bytes.empty()) continue;
+				result.receive(i, bytes);
+				channels[i]->consume(bytes.size());
+				received = true;
+			}
+			if (!received && context->wait(1, 100ms) == 0) break;
+		}
+		const auto syscalls = context->syscall_count() - begin;
+		sender.join();
+		channels.clear();
+		for (const auto& pair : pairs) ::close(pair.second);
+		report(name, result.latencies, syscalls);
+#endif
+	}
+
+	/// @brief 写入路径：测量 write 调用本身的耗时，读取线程只负责排空
+	void write_path(const char* name, const std::shared_ptr<posix::uring_context>& context) {
+		const auto [read_fd, write_fd] = make_pipe();
+		const auto writer = posix::make_uring_rwer(context, write_fd);
+		// 与读取路径相同，排空线程在写入结束后不能阻塞在空管道上
+		posix::details::set_nonblock(read_fd);
+		std::atomic_bool running{ true };
+		std::thread drain{ [&, fd = read_fd] {
+			std::array<byte_type, 16384> buffer{};
+			bool closed{ false };
+			while (!closed && (running || posix::details::wait_for(fd, POLLIN, 10ms)))
+				(void)posix::details::read_some(fd, buffer, 10ms, closed);
+		} };
+
+		std::vector<std::int64_t> costs;
+		costs.reserve(frame_count);
+		const auto begin = context ? context->syscall_count() : 0;
+		for (std::uint64_t sequence = 0; sequence < frame_count; sequence++) {
+			const frame value{ now_ns(), sequence };
+			const auto start = clock_type::now();
+			(void)writer->write(const_byte_span{ reinterpret_cast<const byte_type*>(&value), sizeof(value) });
+			costs.push_back(to_ns(clock_type::now() - start));
+		}
+#if LY_COMMUNICATING_IO_URING
+		if (const auto channel = std::dynamic_pointer_cast<posix::uring_channel>(writer)) (void)channel->flush();
+#endif
+		// 普通写入每次 write 至少一次系统调用
+		const auto syscalls = context ? context->syscall_count() - begin : frame_count;
+		running = false;
+		drain.join();
+		::close(read_fd);
+		report(name, costs, syscalls);
+	}
+}
+
+int main() {
+	const auto context = posix::uring_context::create();
+	std::cout << std::format("io_uring: {} fixed_buffers={}\n",
+		context ? "available" : "unavailable", context && context->has_fixed_buffers());
+
+	plain_read("read pipe x1 plain", { make_pipe() });
+	uring_read("read pipe x1 uring", { make_pipe() });
+	plain_read("read pipe x4 plain", { make_pipe(), make_pipe(), make_pipe(), make_pipe() });
+	uring_read("read pipe x4 uring", { make_pipe(), make_pipe(), make_pipe(), make_pipe() });
+	plain_read("read pty x1 plain", { make_pty() });
+	uring_read("read pty x1 uring", { make_pty() });
+
+	write_path("write pipe plain", nullptr);
+	write_path("write pipe uring", context);
+	return 0;
+}